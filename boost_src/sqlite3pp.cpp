@@ -64,6 +64,132 @@ namespace sqlite3pp
 
   } // namespace
 
+  statement_cache::statement_cache(std::size_t capacity) : capacity_(capacity), hits_(0), misses_(0), evictions_(0)
+  {
+  }
+
+  statement_cache::~statement_cache()
+  {
+    clear();
+  }
+
+  void statement_cache::set_capacity(std::size_t capacity)
+  {
+    capacity_ = capacity;
+    shrink(capacity_);
+  }
+
+  std::size_t statement_cache::capacity() const
+  {
+    return capacity_;
+  }
+
+  std::size_t statement_cache::size() const
+  {
+    return lru_.size();
+  }
+
+  unsigned long long statement_cache::hits() const
+  {
+    return hits_;
+  }
+
+  unsigned long long statement_cache::misses() const
+  {
+    return misses_;
+  }
+
+  unsigned long long statement_cache::evictions() const
+  {
+    return evictions_;
+  }
+
+  void statement_cache::clear()
+  {
+    // Statements still borrowed by a command or query can't be finalized
+    // yet. They are only taken out of the index, so that nobody else gets
+    // them, and are finalized when they come back.
+    for (entries::iterator it = lru_.begin(); it != lru_.end();) {
+      if (it->busy) {
+        unindex(it);
+        it->stale = true;
+        ++it;
+        continue;
+      }
+      it = erase(it);
+    }
+  }
+
+  bool statement_cache::acquire(std::string const& sql, entries::iterator& it)
+  {
+    std::pair<index::iterator, index::iterator> range = index_.equal_range(sql);
+    for (index::iterator i = range.first; i != range.second; ++i) {
+      if (!i->second->busy) {
+        it = i->second;
+        it->busy = true;
+        lru_.splice(lru_.begin(), lru_, it);
+        ++hits_;
+        return true;
+      }
+    }
+    ++misses_;
+    return false;
+  }
+
+  statement_cache::entries::iterator statement_cache::insert(std::string const& sql, sqlite3_stmt* stmt, std::size_t tail)
+  {
+    entry e;
+    e.sql = sql;
+    e.stmt = stmt;
+    e.tail = tail;
+    e.busy = true;
+    e.stale = false;
+    lru_.push_front(e);
+    index_.insert(std::make_pair(sql, lru_.begin()));
+    shrink(capacity_);
+    return lru_.begin();
+  }
+
+  void statement_cache::release(entries::iterator it)
+  {
+    it->busy = false;
+    if (it->stale) {
+      sqlite3_finalize(it->stmt);
+      lru_.erase(it);
+      return;
+    }
+    shrink(capacity_);
+  }
+
+  statement_cache::entries::iterator statement_cache::erase(entries::iterator it)
+  {
+    unindex(it);
+    sqlite3_finalize(it->stmt);
+    return lru_.erase(it);
+  }
+
+  void statement_cache::unindex(entries::iterator it)
+  {
+    std::pair<index::iterator, index::iterator> range = index_.equal_range(it->sql);
+    for (index::iterator i = range.first; i != range.second; ++i) {
+      if (i->second == it) {
+        index_.erase(i);
+        break;
+      }
+    }
+  }
+
+  void statement_cache::shrink(std::size_t size)
+  {
+    entries::iterator it = lru_.end();
+    while (lru_.size() > size && it != lru_.begin()) {
+      --it;
+      if (it->busy) continue;
+      it = erase(it);
+      ++evictions_;
+    }
+  }
+
   database::database(char const* dbname) : db_(0)
   {
     if (dbname) {
@@ -96,6 +222,8 @@ namespace sqlite3pp
   {
     int rc = SQLITE_OK;
     if (db_) {
+      sc_.clear();
+
       rc = sqlite3_close(db_);
       if (rc == SQLITE_OK) {
         db_ = 0;
@@ -180,8 +308,18 @@ namespace sqlite3pp
     return sqlite3_busy_timeout(db_, ms);
   }
 
+  statement_cache& database::stmt_cache()
+  {
+    return sc_;
+  }
+
+  statement_cache const& database::stmt_cache() const
+  {
+    return sc_;
+  }
+
 
-  statement::statement(database& db, char const* stmt) : db_(db), stmt_(0), tail_(0)
+  statement::statement(database& db, char const* stmt) : db_(db), stmt_(0), tail_(0), cached_(false)
   {
     if (stmt) {
       int rc = prepare(stmt);
@@ -203,7 +341,23 @@ namespace sqlite3pp
     if (rc != SQLITE_OK)
       return rc;
 
-    return prepare_impl(stmt);
+    if (db_.sc_.capacity() == 0)
+      return prepare_impl(stmt);
+
+    std::string sql(stmt);
+    if (db_.sc_.acquire(sql, centry_)) {
+      stmt_ = centry_->stmt;
+      tail_ = stmt + centry_->tail;
+      cached_ = true;
+      return SQLITE_OK;
+    }
+
+    rc = prepare_impl(stmt);
+    if (rc == SQLITE_OK && stmt_) {
+      centry_ = db_.sc_.insert(sql, stmt_, tail_ - stmt);
+      cached_ = true;
+    }
+    return rc;
   }
 
   int statement::prepare_impl(char const* stmt)
@@ -225,6 +379,14 @@ namespace sqlite3pp
 
   int statement::finish_impl(sqlite3_stmt* stmt)
   {
+    if (cached_ && centry_->stmt == stmt) {
+      // Hand the statement back to the cache instead of finalizing it.
+      cached_ = false;
+      int rc = sqlite3_reset(stmt);
+      sqlite3_clear_bindings(stmt);
+      db_.sc_.release(centry_);
+      return rc;
+    }
     return sqlite3_finalize(stmt);
   }
 
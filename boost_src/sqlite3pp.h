@@ -25,6 +25,9 @@
 #ifndef SQLITE3PP_H
 #define SQLITE3PP_H
 
+#include <cstddef>
+#include <list>
+#include <map>
 #include <string>
 #include <stdexcept>
 #include <sqlite3.h>
@@ -44,6 +47,57 @@ namespace sqlite3pp
   class null_type {};
   extern null_type ignore;
 
+  class statement_cache : boost::noncopyable
+  {
+    friend class database;
+    friend class statement;
+
+   public:
+    explicit statement_cache(std::size_t capacity = 0);
+    ~statement_cache();
+
+    void set_capacity(std::size_t capacity);
+    std::size_t capacity() const;
+    std::size_t size() const;
+
+    unsigned long long hits() const;
+    unsigned long long misses() const;
+    unsigned long long evictions() const;
+
+    void clear();
+
+   private:
+    // A stale entry was cleared while borrowed, and goes when it comes
+    // back.
+    struct entry
+    {
+      std::string sql;
+      sqlite3_stmt* stmt;
+      std::size_t tail;
+      bool busy;
+      bool stale;
+    };
+
+    typedef std::list<entry> entries;
+    typedef std::multimap<std::string, entries::iterator> index;
+
+    bool acquire(std::string const& sql, entries::iterator& it);
+    entries::iterator insert(std::string const& sql, sqlite3_stmt* stmt, std::size_t tail);
+    void release(entries::iterator it);
+    entries::iterator erase(entries::iterator it);
+    void unindex(entries::iterator it);
+    void shrink(std::size_t size);
+
+   private:
+    std::size_t capacity_;
+    entries lru_;
+    index index_;
+
+    unsigned long long hits_;
+    unsigned long long misses_;
+    unsigned long long evictions_;
+  };
+
   class database : boost::noncopyable
   {
     friend class statement;
@@ -84,6 +138,9 @@ namespace sqlite3pp
     void set_update_handler(update_handler h);
     void set_authorize_handler(authorize_handler h);
 
+    statement_cache& stmt_cache();
+    statement_cache const& stmt_cache() const;
+
    private:
     sqlite3* db_;
 
@@ -92,6 +149,8 @@ namespace sqlite3pp
     rollback_handler rh_;
     update_handler uh_;
     authorize_handler ah_;
+
+    statement_cache sc_;
   };
 
   class database_error : public std::runtime_error
@@ -137,6 +196,8 @@ namespace sqlite3pp
     database& db_;
     sqlite3_stmt* stmt_;
     char const* tail_;
+    statement_cache::entries::iterator centry_;
+    bool cached_;
   };
 
   class command : public statement
@@ -30,12 +30,37 @@
 #define SQLITE3PP_VERSION_MINOR 0
 #define SQLITE3PP_VERSION_PATCH 6
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <functional>
 #include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <sqlite3.h>
 #include <stdexcept>
+#include <streambuf>
 #include <string>
 #include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define SQLITE3PP_HAS_STRING_VIEW
+#include <string_view>
+#endif
+
+#if !defined(SQLITE_OMIT_DESERIALIZE) && (SQLITE_VERSION_NUMBER >= 3036000 || defined(SQLITE_ENABLE_DESERIALIZE))
+#define SQLITE3PP_HAS_SERIALIZE
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SQLITE3PP_HAS_MMAP
+#endif
 
 namespace sqlite3pp
 {
@@ -43,15 +68,51 @@ namespace sqlite3pp
   {
     class function;
     class aggregate;
+    template <class T> class vtable;
+    class session;
+    class changeset;
   }
 
+  class image;
+  class checkpoint_scheduler;
+
   template <class T>
   struct convert {
     using to_int = int;
   };
 
+  template <std::size_t... Is>
+  struct index_sequence {};
+
+  template <std::size_t N, std::size_t... Is>
+  struct make_index_sequence : make_index_sequence<N - 1, N - 1, Is...> {};
+
+  template <std::size_t... Is>
+  struct make_index_sequence<0, Is...> {
+    using type = index_sequence<Is...>;
+  };
+
   class null_type {};
 
+  struct blob_view
+  {
+    void const* data;
+    int size;
+  };
+
+  // Column types that point into the memory of a statement instead of
+  // holding their value.
+  template <class T>
+  struct is_view : std::is_pointer<T> {};
+
+  template <>
+  struct is_view<blob_view> : std::true_type {};
+
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+  template <>
+  struct is_view<std::string_view> : std::true_type {};
+#endif
+
   class noncopyable
   {
    protected:
@@ -65,12 +126,75 @@ namespace sqlite3pp
     noncopyable& operator=(noncopyable const&) = delete;
   };
 
+  class statement_cache : noncopyable
+  {
+    friend class database;
+    friend class statement;
+
+   public:
+    explicit statement_cache(std::size_t capacity = 0);
+
+    statement_cache(statement_cache&& sc);
+    statement_cache& operator=(statement_cache&& sc);
+
+    ~statement_cache();
+
+    void set_capacity(std::size_t capacity);
+    std::size_t capacity() const;
+    std::size_t size() const;
+
+    unsigned long long hits() const;
+    unsigned long long misses() const;
+    unsigned long long evictions() const;
+
+    void clear();
+
+   private:
+    // Statements are looked up by their SQL text and prepflags. A stale
+    // entry was cleared while borrowed, and goes when it comes back.
+    struct entry
+    {
+      std::string sql;
+      unsigned int prepflags;
+      sqlite3_stmt* stmt;
+      std::size_t tail;
+      bool busy;
+      bool stale;
+    };
+
+    using entries = std::list<entry>;
+
+    bool acquire(std::string const& sql, unsigned int prepflags, entries::iterator& it);
+    entries::iterator insert(std::string const& sql, unsigned int prepflags, sqlite3_stmt* stmt, std::size_t tail);
+    void release(entries::iterator it);
+    entries::iterator erase(entries::iterator it);
+    void unindex(entries::iterator it);
+    void shrink(std::size_t size);
+
+   private:
+    std::size_t capacity_;
+    entries lru_;
+    std::unordered_multimap<std::string, entries::iterator> index_;
+
+    unsigned long long hits_;
+    unsigned long long misses_;
+    unsigned long long evictions_;
+  };
+
   class database : noncopyable
   {
     friend class statement;
     friend class database_error;
+    friend class blob;
+    friend class backup_job;
+    friend class checkpoint_scheduler;
+    friend class transaction;
+    friend class savepoint;
     friend class ext::function;
     friend class ext::aggregate;
+    template <class T> friend class ext::vtable;
+    friend class ext::session;
+    friend class ext::changeset;
 
    public:
     using busy_handler = std::function<int (int)>;
@@ -79,8 +203,29 @@ namespace sqlite3pp
     using update_handler = std::function<void (int, char const*, char const*, long long int)>;
     using authorize_handler = std::function<int (int, char const*, char const*, char const*, char const*)>;
     using backup_handler = std::function<void (int, int, int)>;
+    using trace_handler = std::function<int (unsigned int, void*, void*)>;
+    using progress_handler = std::function<int ()>;
+    using wal_handler = std::function<int (char const*, int)>;
+
+    // Settings applied right after the database is opened. The defaults
+    // leave SQLite's own settings alone. cache_size is in pages, or in KiB
+    // if negative, as in PRAGMA cache_size. page_size only changes a new
+    // database, or an existing one at the next VACUUM outside WAL mode.
+    struct options
+    {
+      long long int mmap_size = -1;
+      int cache_size = 0;
+      int page_size = 0;
+      std::string journal_mode;
+      int synchronous = -1;
+      int temp_store = -1;
+      int wal_autocheckpoint = -1;
+      int lookaside_size = 0;
+      int lookaside_count = 0;
+    };
 
     explicit database(char const* dbname = nullptr, int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, const char* vfs = nullptr);
+    explicit database(char const* dbname, options const& opts, int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, const char* vfs = nullptr);
 
     database(database&& db);
     database& operator=(database&& db);
@@ -88,6 +233,9 @@ namespace sqlite3pp
     ~database();
 
     int connect(char const* dbname, int flags, const char* vfs = nullptr);
+
+    // The database is closed again if any of opts can't be applied.
+    int connect(char const* dbname, options const& opts, int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, const char* vfs = nullptr);
     int disconnect();
 
     int attach(char const* dbname, char const* name);
@@ -102,8 +250,42 @@ namespace sqlite3pp
     int enable_triggers(bool enable = true);
     int enable_extended_result_codes(bool enable = true);
 
+    // Applies opts to the open database, or reads back the settings in
+    // effect. Lookaside can only be set before the connection is used, so
+    // it's left out of both.
+    int tune(options const& opts);
+    options tune() const;
+
+#ifdef SQLITE3PP_HAS_SERIALIZE
+    // Writes the schema into img. With fnocopy, img points into the memory
+    // of an in-memory database instead, which is good until the database
+    // changes. Other databases are copied anyway.
+    int serialize(image& img, char const* schema = "main", bool fnocopy = false) const;
+
+    // Replaces the schema with the database in img, which gives its memory
+    // to SQLite. An img that doesn't own its memory is copied first.
+    int deserialize(image&& img, char const* schema = "main", bool freadonly = false);
+
+    // Opens n bytes at data read-only in place, without a copy. They have
+    // to stay valid until the schema is closed or replaced. Unlike an
+    // image, they can't hold a WAL database, whose header needs a change.
+    int deserialize(void const* data, std::size_t n, char const* schema = "main");
+#endif
+
     int changes() const;
 
+    // The file of the schema, or an empty string for a temporary or
+    // in-memory one.
+    char const* filename(char const* dbname = "main") const;
+
+    // Checkpoints the WAL of dbname, or of every schema if it's null. log
+    // gets the frames in the WAL and ckpt the frames now in the database.
+    int checkpoint(char const* dbname = nullptr, int mode = SQLITE_CHECKPOINT_PASSIVE, int* log = nullptr, int* ckpt = nullptr);
+
+    // Makes the statements running on the connection fail with
+    // SQLITE_INTERRUPT. It can be called from any thread.
+    void interrupt();
+
     int error_code() const;
     int extended_error_code() const;
     char const* error_msg() const;
@@ -111,6 +293,16 @@ namespace sqlite3pp
     int execute(char const* sql);
     int executef(char const* sql, ...);
 
+    // Runs sql with args bound to its parameters in order, on statements
+    // from stmt_cache(). Text and blobs are bound without a copy.
+    template <class T, class... Ts>
+    int execute(char const* sql, T const& arg, Ts const&... args);
+
+    // Returns the first column of the first row, or throws database_error
+    // if there is none.
+    template <class T, class... Ts>
+    T query_one(char const* sql, Ts const&... args);
+
     int set_busy_timeout(int ms);
 
     void set_busy_handler(busy_handler h);
@@ -119,6 +311,30 @@ namespace sqlite3pp
     void set_update_handler(update_handler h);
     void set_authorize_handler(authorize_handler h);
 
+    // mask is a set of SQLITE_TRACE_* codes. h gets the event code and the
+    // two arguments of a sqlite3_trace_v2() callback.
+    void set_trace_handler(unsigned int mask, trace_handler h);
+
+    // h is called about every n virtual machine steps. Returning nonzero
+    // interrupts the running statement.
+    void set_progress_handler(int n, progress_handler h);
+
+    // h gets the schema and the pages in its WAL after each commit. It
+    // replaces the automatic checkpoints, which stay off once h is
+    // removed, until set again with wal_autocheckpoint.
+    void set_wal_handler(wal_handler h);
+
+    statement_cache& stmt_cache();
+    statement_cache const& stmt_cache() const;
+
+   private:
+    // Runs one of the transaction control statements, which are prepared
+    // once and kept until disconnect().
+    int execute_xct(std::string const& sql);
+
+    long long int pragma_int(char const* name) const;
+    std::string pragma_text(char const* name) const;
+
    private:
     sqlite3* db_;
 
@@ -127,6 +343,14 @@ namespace sqlite3pp
     rollback_handler rh_;
     update_handler uh_;
     authorize_handler ah_;
+    trace_handler th_;
+    progress_handler ph_;
+    wal_handler wh_;
+
+    statement_cache sc_;
+
+    std::unordered_map<std::string, sqlite3_stmt*> xcts_;
+    int spdepth_;
   };
 
   class database_error : public std::runtime_error
@@ -140,8 +364,12 @@ namespace sqlite3pp
 
   class statement : noncopyable
   {
+    friend class database;
+    friend class bulk_inserter;
+    friend class shard_set;
+
    public:
-    int prepare(char const* stmt);
+    int prepare(char const* stmt, unsigned int prepflags = 0, int nbytes = -1);
     int finish();
 
     int bind(int idx, int value);
@@ -150,6 +378,10 @@ namespace sqlite3pp
     int bind(int idx, char const* value, copy_semantic fcopy);
     int bind(int idx, void const* value, int n, copy_semantic fcopy);
     int bind(int idx, std::string const& value, copy_semantic fcopy);
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+    int bind(int idx, std::string_view value, copy_semantic fcopy);
+#endif
+    int bind(int idx, blob_view value, copy_semantic fcopy);
     int bind(int idx);
     int bind(int idx, null_type);
 
@@ -159,23 +391,128 @@ namespace sqlite3pp
     int bind(char const* name, char const* value, copy_semantic fcopy);
     int bind(char const* name, void const* value, int n, copy_semantic fcopy);
     int bind(char const* name, std::string const& value, copy_semantic fcopy);
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+    int bind(char const* name, std::string_view value, copy_semantic fcopy);
+#endif
+    int bind(char const* name, blob_view value, copy_semantic fcopy);
     int bind(char const* name);
     int bind(char const* name, null_type);
 
+    int bind_text(int idx, char const* value, std::size_t n, copy_semantic fcopy);
+    int bind_text(char const* name, char const* value, std::size_t n, copy_semantic fcopy);
+
+    int bind_zeroblob(int idx, long long int n);
+    int bind_zeroblob(char const* name, long long int n);
+
     int step();
     int reset();
 
+    // Returns a sqlite3_stmt_status() counter, summed over all the
+    // statements in the SQL text.
+    int stmt_status(int op, bool freset = false);
+
    protected:
-    explicit statement(database& db, char const* stmt = nullptr);
+    explicit statement(database& db, char const* stmt = nullptr, unsigned int prepflags = 0, int nbytes = -1);
     ~statement();
 
-    int prepare_impl(char const* stmt);
+    int prepare_impl(char const* stmt, int nbytes, sqlite3_stmt** ppstmt, char const** ptail);
+
+    // Binds values to the parameters from idx on. Text and blobs aren't
+    // copied, so the values have to outlive the run.
+    int bind_args(int /*idx*/) { return SQLITE_OK; }
+
+    template <class T, class... Ts>
+    int bind_args(int idx, T const& value, Ts const&... values) {
+      auto rc = bind_arg(idx, value);
+      return rc == SQLITE_OK ? bind_args(idx + 1, values...) : rc;
+    }
+
+    int bind_arg(int idx, int value);
+    int bind_arg(int idx, double value);
+    int bind_arg(int idx, long long int value);
+
+    // Any other integer (int64_t, size_t, bool, ...) binds as a long long
+    // and any other floating point type as a double.
+    template <class T>
+    typename std::enable_if<std::is_integral<T>::value, int>::type bind_arg(int idx, T value) {
+      return bind_arg(idx, static_cast<long long int>(value));
+    }
+
+    template <class T>
+    typename std::enable_if<std::is_floating_point<T>::value, int>::type bind_arg(int idx, T value) {
+      return bind_arg(idx, static_cast<double>(value));
+    }
+
+    int bind_arg(int idx, char const* value);
+    int bind_arg(int idx, std::string const& value);
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+    int bind_arg(int idx, std::string_view value);
+#endif
+    int bind_arg(int idx, blob_view value);
+    int bind_arg(int idx, null_type);
+
+    int prepare_chain();
     int finish_impl(sqlite3_stmt* stmt);
+    int remaining(char const* sql) const;
+    std::vector<int> map_params(sqlite3_stmt* stmt);
+    int param_index(char const* name);
+    sqlite3_stmt* value_holder();
+    int keep_value(int idx);
+
+    // Binds a value to stmt_ and to the same parameter of every statement
+    // that follows it in the SQL text, so they share one binding set.
+    // Indexes past the parameters of stmt_ are named parameters that only
+    // the following statements have. While some of those can't be
+    // prepared yet, a copy of the value is kept for them.
+    template <class F>
+    int bind_impl(int idx, F f) {
+      if (!fchained_) {
+        auto rc = prepare_chain();
+        if (rc != SQLITE_OK) return rc;
+      }
+      auto rc = SQLITE_RANGE;
+      if (idx <= sqlite3_bind_parameter_count(stmt_)) {
+        rc = f(stmt_, idx);
+        if (rc != SQLITE_OK) return rc;
+      }
+      for (auto const& sub : subs_) {
+        if (idx > 0 && idx < static_cast<int>(sub.params.size()) && sub.params[idx] > 0) {
+          rc = f(sub.stmt, sub.params[idx]);
+          if (rc != SQLITE_OK) return rc;
+        }
+      }
+      if (rc == SQLITE_OK && pending_) {
+        auto holder = value_holder();
+        rc = holder ? f(holder, 1) : db_.error_code();
+        if (rc == SQLITE_OK) rc = keep_value(idx);
+      }
+      return rc;
+    }
 
    protected:
+    struct substatement
+    {
+      sqlite3_stmt* stmt;
+      std::vector<int> params;
+    };
+
     database& db_;
     sqlite3_stmt* stmt_;
     char const* tail_;
+    char const* sqlend_;
+    unsigned int prepflags_;
+    statement_cache::entries::iterator centry_;
+    bool cached_;
+    std::vector<substatement> subs_;
+    std::vector<char const*> subnames_;
+    char const* pending_;
+    sqlite3_stmt* holder_;
+    std::vector<sqlite3_value*> values_;
+    bool fchained_;
+    bool fexhausted_;
+    // Tells apart every prepare(), even of a reused object or address.
+    unsigned long long serial_;
+    mutable std::vector<std::pair<std::string, int>> colnames_;
   };
 
   class command : public statement
@@ -186,6 +523,13 @@ namespace sqlite3pp
      public:
       bindstream(command& cmd, int idx);
 
+      // Sets how the text and blob values that follow are bound, e.g.
+      // cmd.binder() << sqlite3pp::nocopy << payload;
+      bindstream& operator << (copy_semantic fcopy) {
+        fcopy_ = fcopy;
+        return *this;
+      }
+
       template <class T>
       bindstream& operator << (T value) {
         auto rc = cmd_.bind(idx_, value);
@@ -196,7 +540,7 @@ namespace sqlite3pp
         return *this;
       }
       bindstream& operator << (char const* value) {
-        auto rc = cmd_.bind(idx_, value, copy);
+        auto rc = cmd_.bind(idx_, value, fcopy_);
         if (rc != SQLITE_OK) {
           throw database_error(cmd_.db_);
         }
@@ -204,7 +548,25 @@ namespace sqlite3pp
         return *this;
       }
       bindstream& operator << (std::string const& value) {
-        auto rc = cmd_.bind(idx_, value, copy);
+        auto rc = cmd_.bind(idx_, value, fcopy_);
+        if (rc != SQLITE_OK) {
+          throw database_error(cmd_.db_);
+        }
+        ++idx_;
+        return *this;
+      }
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+      bindstream& operator << (std::string_view value) {
+        auto rc = cmd_.bind(idx_, value, fcopy_);
+        if (rc != SQLITE_OK) {
+          throw database_error(cmd_.db_);
+        }
+        ++idx_;
+        return *this;
+      }
+#endif
+      bindstream& operator << (blob_view value) {
+        auto rc = cmd_.bind(idx_, value, fcopy_);
         if (rc != SQLITE_OK) {
           throw database_error(cmd_.db_);
         }
@@ -215,9 +577,10 @@ namespace sqlite3pp
      private:
       command& cmd_;
       int idx_;
+      copy_semantic fcopy_;
     };
 
-    explicit command(database& db, char const* stmt = nullptr);
+    explicit command(database& db, char const* stmt = nullptr, unsigned int prepflags = 0, int nbytes = -1);
 
     bindstream binder(int idx = 1);
 
@@ -225,6 +588,79 @@ namespace sqlite3pp
     int execute_all();
   };
 
+  // Rows of a query stored column by column by query::fetch_batch. Each
+  // column keeps one type, picked from its declared type or else from its
+  // first value. INTEGER and FLOAT columns fill ints or reals, TEXT and
+  // BLOB columns append to bytes and row i spans [offsets[i],
+  // offsets[i + 1]). Bit i % 8 of valid[i / 8] is clear for a NULL. The
+  // buffers keep their capacity from batch to batch.
+  class column_batch
+  {
+    friend class query;
+
+   public:
+    struct column
+    {
+      int type = 0;
+      std::vector<long long int> ints;
+      std::vector<double> reals;
+      std::vector<std::size_t> offsets;
+      std::vector<char> bytes;
+      std::vector<unsigned char> valid;
+
+      bool is_null(std::size_t row) const;
+      char const* data(std::size_t row) const;
+      std::size_t length(std::size_t row) const;
+    };
+
+    column_batch();
+
+    std::size_t size() const;
+    int column_count() const;
+    column const& operator[](int idx) const;
+
+    void clear();
+
+   private:
+    std::vector<column> columns_;
+    std::size_t rows_;
+    unsigned long long source_;
+  };
+
+  // A monotonic buffer. Allocations come out of large blocks and are all
+  // released at once by reset(), which keeps the blocks for reuse.
+  class arena : noncopyable
+  {
+   public:
+    explicit arena(std::size_t block_size = 64 * 1024);
+
+    arena(arena&& a);
+    arena& operator=(arena&& a);
+
+    void* allocate(std::size_t n, std::size_t align = alignof(std::max_align_t));
+
+    // Copies n bytes followed by a NUL.
+    char const* copy(void const* data, std::size_t n);
+
+    void reset();
+
+    std::size_t used() const;
+    std::size_t capacity() const;
+
+   private:
+    struct block
+    {
+      std::unique_ptr<char[]> data;
+      std::size_t size;
+    };
+
+    std::vector<block> blocks_;
+    std::size_t block_size_;
+    std::size_t cur_;
+    std::size_t off_;
+    std::size_t used_;
+  };
+
   class query : public statement
   {
    public:
@@ -248,7 +684,7 @@ namespace sqlite3pp
         int idx_;
       };
 
-      explicit rows(sqlite3_stmt* stmt);
+      explicit rows(sqlite3_stmt* stmt, query const* cmd = nullptr);
 
       int data_count() const;
       int column_type(int idx) const;
@@ -259,6 +695,13 @@ namespace sqlite3pp
         return get(idx, T());
       }
 
+      // Throws database_error if there is no column with that exact name.
+      template <class T> T get(char const* name) const {
+        return get(column_index(name), T());
+      }
+
+      int column_index(char const* name) const;
+
       template <class... Ts>
       std::tuple<Ts...> get_columns(typename convert<Ts>::to_int... idxs) const {
         return std::make_tuple(get(idxs, Ts())...);
@@ -272,11 +715,16 @@ namespace sqlite3pp
       long long int get(int idx, long long int) const;
       char const* get(int idx, char const*) const;
       std::string get(int idx, std::string) const;
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+      std::string_view get(int idx, std::string_view) const;
+#endif
       void const* get(int idx, void const*) const;
+      blob_view get(int idx, blob_view) const;
       null_type get(int idx, null_type) const;
 
      private:
       sqlite3_stmt* stmt_;
+      query const* cmd_;
     };
 
     class query_iterator
@@ -298,23 +746,199 @@ namespace sqlite3pp
       int rc_;
     };
 
-    explicit query(database& db, char const* stmt = nullptr);
+    template <class T, class F>
+    class typed_iterator
+    {
+     public:
+      using iterator_category = std::input_iterator_tag;
+      using value_type = T;
+      using difference_type = std::ptrdiff_t;
+      using pointer = T const*;
+      using reference = T const&;
+
+      typed_iterator() : cmd_(nullptr), value_(nullptr), decode_(nullptr), rc_(SQLITE_DONE) {
+      }
+      typed_iterator(query* cmd, T* value, F* decode) : cmd_(cmd), value_(value), decode_(decode) {
+        step();
+      }
+
+      bool operator==(typed_iterator const& other) const {
+        return rc_ == other.rc_;
+      }
+      bool operator!=(typed_iterator const& other) const {
+        return rc_ != other.rc_;
+      }
+
+      typed_iterator& operator++() {
+        step();
+        return *this;
+      }
+
+      T const& operator*() const {
+        return *value_;
+      }
+      T const* operator->() const {
+        return value_;
+      }
+
+     private:
+      void step() {
+        rc_ = cmd_->step();
+        if (rc_ == SQLITE_ROW) {
+          (*decode_)(rows(cmd_->stmt_, cmd_), *value_);
+        }
+        else if (rc_ != SQLITE_DONE) {
+          throw database_error(cmd_->db_);
+        }
+      }
+
+      query* cmd_;
+      T* value_;
+      F* decode_;
+      int rc_;
+    };
+
+    // Decodes every row into the same object, so strings keep their
+    // buffers from row to row.
+    template <class T, class F>
+    class typed_range
+    {
+     public:
+      using iterator = typed_iterator<T, F>;
+
+      typed_range(query* cmd, F decode) : cmd_(cmd), value_(), decode_(decode) {
+      }
+
+      iterator begin() {
+        return iterator(cmd_, &value_, &decode_);
+      }
+      iterator end() {
+        return iterator();
+      }
+
+     private:
+      query* cmd_;
+      T value_;
+      F decode_;
+    };
+
+    template <class... Ts>
+    struct tuple_decoder
+    {
+      void operator()(rows const& r, std::tuple<Ts...>& value) const {
+        decode(r, value, typename make_index_sequence<sizeof...(Ts)>::type());
+      }
+
+      template <std::size_t... Is>
+      static void decode(rows const& r, std::tuple<Ts...>& value, index_sequence<Is...>) {
+        int expand[] = {0, ((void) (std::get<Is>(value) = r.get<Ts>(static_cast<int>(Is))), 0)...};
+        (void) expand;
+      }
+    };
+
+    template <class T, class... Ms>
+    struct member_decoder
+    {
+      void operator()(rows const& r, T& value) const {
+        decode(r, value, typename make_index_sequence<sizeof...(Ms)>::type());
+      }
+
+      template <std::size_t... Is>
+      void decode(rows const& r, T& value, index_sequence<Is...>) const {
+        int expand[] = {0, ((void) (value.*std::get<Is>(members) = r.get<Ms>(static_cast<int>(Is))), 0)...};
+        (void) expand;
+      }
+
+      std::tuple<Ms T::*...> members;
+    };
+
+    explicit query(database& db, char const* stmt = nullptr, unsigned int prepflags = 0, int nbytes = -1);
 
     int column_count() const;
 
     char const* column_name(int idx) const;
     char const* column_decltype(int idx) const;
 
+    // Returns -1 if there is no column with that exact name. The first
+    // call builds the lookup table, which lives until finish().
+    int column_index(char const* name) const;
+
+    // While an arena is set, char const*, string_view and blob_view
+    // columns are copied into it, so they stay valid after the next step
+    // until the arena is reset.
+    void set_arena(arena* a);
+    arena* get_arena() const;
+
     using iterator = query_iterator;
 
     iterator begin();
     iterator end();
+
+    // Steps through up to n more rows into batch and returns how many it
+    // got, which is 0 at the end until reset().
+    std::size_t fetch_batch(column_batch& batch, std::size_t n);
+
+    // for (auto const& row : qry.as<int, std::string>()) ...
+    // Row i's column j goes into std::get<j>(row).
+    template <class... Ts>
+    typed_range<std::tuple<Ts...>, tuple_decoder<Ts...>> as() {
+      return typed_range<std::tuple<Ts...>, tuple_decoder<Ts...>>(this, tuple_decoder<Ts...>());
+    }
+
+    // for (auto const& c : qry.as_struct(&contact::id, &contact::name)) ...
+    // Column j goes into the j-th member.
+    template <class T, class... Ms>
+    typed_range<T, member_decoder<T, Ms...>> as_struct(Ms T::*... members) {
+      return typed_range<T, member_decoder<T, Ms...>>(this, member_decoder<T, Ms...>{std::make_tuple(members...)});
+    }
+
+   private:
+    int column_kind(int idx) const;
+
+   private:
+    arena* arena_;
+  };
+
+  template <class T, class... Ts>
+  int database::execute(char const* sql, T const& arg, Ts const&... args)
+  {
+    command cmd(*this);
+    auto rc = cmd.prepare(sql);
+    if (rc == SQLITE_OK)
+      rc = cmd.bind_args(1, arg, args...);
+    if (rc == SQLITE_OK)
+      rc = cmd.execute_all();
+    return rc;
+  }
+
+  template <class T, class... Ts>
+  T database::query_one(char const* sql, Ts const&... args)
+  {
+    // The statement is reset before returning, which frees what a pointer
+    // or a view would point to.
+    static_assert(!is_view<T>::value, "query_one() needs a type that holds its value");
+
+    query qry(*this, sql);
+    if (qry.bind_args(1, args...) != SQLITE_OK)
+      throw database_error(*this);
+    auto it = qry.begin();
+    if (it == qry.end())
+      throw database_error("query_one: no rows");
+    return (*it).template get<T>(0);
+  }
+
+  enum class transaction_mode
+  {
+    deferred,
+    immediate,
+    exclusive
   };
 
   class transaction : noncopyable
   {
    public:
     explicit transaction(database& db, bool fcommit = false, bool freserve = false);
+    explicit transaction(database& db, transaction_mode mode, bool fcommit = false);
     ~transaction();
 
     int commit();
@@ -325,6 +949,345 @@ namespace sqlite3pp
     bool fcommit_;
   };
 
+  // A nested transaction. Savepoints can be opened inside a transaction or
+  // inside each other, and roll back only their own changes.
+  class savepoint : noncopyable
+  {
+   public:
+    explicit savepoint(database& db, bool frelease = false);
+    ~savepoint();
+
+    int release();
+    int rollback();
+
+   private:
+    database* db_;
+    bool frelease_;
+    std::string name_;
+  };
+
+  // Tuning for backup_job. A zero step_time keeps step_page fixed.
+  struct backup_options
+  {
+    int step_page = 64;
+    int min_step_page = 1;
+    int max_step_page = 4096;
+    std::chrono::milliseconds step_time{10};
+    std::chrono::milliseconds backoff{10};
+    std::chrono::milliseconds max_backoff{1000};
+    int max_pages_per_sec = 0;
+  };
+
+  // An online backup that is copied a batch of pages at a time. step() can
+  // be driven from an event loop, waiting delay() between calls, or run()
+  // does the whole backup on the calling thread. The batch grows or shrinks
+  // so that a step takes about step_time, BUSY and LOCKED back off from
+  // backoff up to max_backoff, and max_pages_per_sec caps the copy rate.
+  class backup_job : noncopyable
+  {
+    friend class database;
+
+   public:
+    explicit backup_job(database& db, database& destdb, database::backup_handler h = {}, backup_options const& opts = backup_options());
+    explicit backup_job(char const* dbname, database& db, database& destdb, char const* destdbname, database::backup_handler h = {}, backup_options const& opts = backup_options());
+    ~backup_job();
+
+    // Returns SQLITE_OK while there are pages left, SQLITE_BUSY or
+    // SQLITE_LOCKED to retry later, SQLITE_DONE at the end, SQLITE_INTERRUPT
+    // once cancelled, or an error. The job is finished after the last three.
+    int step();
+    int run();
+
+    // Can be called from any thread. The job stops before its next step.
+    void cancel();
+
+    int finish();
+
+    bool done() const;
+    int remaining() const;
+    int pagecount() const;
+    int step_page() const;
+    std::chrono::milliseconds delay() const;
+
+   private:
+    backup_job(sqlite3_backup* bkup, database::backup_handler h, backup_options const& opts);
+
+   private:
+    sqlite3_backup* bkup_;
+    database::backup_handler h_;
+    backup_options opts_;
+    int npage_;
+    int rc_;
+    long long int ncopied_;
+    std::chrono::milliseconds delay_;
+    std::chrono::milliseconds backoff_;
+    std::chrono::steady_clock::time_point start_;
+    std::atomic<bool> cancel_;
+  };
+
+  class blob : noncopyable
+  {
+   public:
+    // Opens the BLOB in column of the row with rowid in table.
+    explicit blob(database& db, char const* table, char const* column, long long int rowid, bool fwrite = false, char const* dbname = "main");
+
+    blob(blob&& b);
+    blob& operator=(blob&& b);
+
+    ~blob();
+
+    int close();
+    int reopen(long long int rowid);
+
+    int size() const;
+
+    int read(void* data, int n, int offset);
+    int write(void const* data, int n, int offset);
+
+   private:
+    database* db_;
+    sqlite3_blob* blob_;
+  };
+
+  // A std::streambuf over a blob, so it can be read or written in chunks
+  // with std::istream and std::ostream. A BLOB can't change its size, so
+  // writing past its end fails.
+  class blobbuf : public std::streambuf
+  {
+   public:
+    explicit blobbuf(blob& b, std::size_t bufsize = 64 * 1024);
+    ~blobbuf();
+
+   protected:
+    int_type underflow() override;
+    int_type overflow(int_type c) override;
+    int sync() override;
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+   private:
+    blob& blob_;
+    std::vector<char> buf_;
+    int off_;
+  };
+
+  // A database file in memory, as written by database::serialize(). It holds
+  // memory from sqlite3_malloc64() unless it points into a database.
+  class image : noncopyable
+  {
+    friend class database;
+
+   public:
+    image();
+    // Copies n bytes at data. Throws std::bad_alloc if it can't.
+    image(void const* data, std::size_t n);
+    image(image&& img);
+    image& operator=(image&& img);
+    ~image();
+
+    // Reads the whole file at path, replacing what the image holds.
+    int load(char const* path);
+
+    unsigned char const* data() const;
+    std::size_t size() const;
+    bool owned() const;
+
+   private:
+    void clear();
+
+   private:
+    unsigned char* data_;
+    std::size_t size_;
+    bool fowned_;
+  };
+
+#ifdef SQLITE3PP_HAS_MMAP
+  // A file mapped read-only, to pass to database::deserialize() without
+  // reading it first. Pages are read in as SQLite touches them.
+  class mapped_file : noncopyable
+  {
+   public:
+    explicit mapped_file(char const* path);
+    mapped_file(mapped_file&& mf);
+    mapped_file& operator=(mapped_file&& mf);
+    ~mapped_file();
+
+    void const* data() const;
+    std::size_t size() const;
+
+   private:
+    void unmap();
+
+   private:
+    void* data_;
+    std::size_t size_;
+  };
+#endif
+
+  class bulk_inserter : noncopyable
+  {
+   public:
+    // Rows are committed every batch_rows rows or batch_bytes bytes of
+    // bound values, whichever comes first. Zero turns a limit off. With
+    // ffast, synchronous is OFF and the rollback journal is kept in memory
+    // until finish(). If a transaction is already open on the database, the
+    // rows go into it and no batches are committed.
+    explicit bulk_inserter(command& cmd, std::size_t batch_rows = 10000, std::size_t batch_bytes = 0, bool ffast = false);
+
+    // Rolls back the rows of the open batch, unless finish() was called.
+    ~bulk_inserter();
+
+    template <class... Ts>
+    void insert(Ts const&... values) {
+      if (!xct_) begin();
+      auto rc = bind_values(1, values...);
+      if (rc == SQLITE_OK) rc = cmd_.step();
+      if (rc != SQLITE_DONE) {
+        // Leave the command ready for the next row.
+        database_error e(cmd_.db_);
+        discard_row();
+        throw e;
+      }
+      cmd_.reset();
+      ++rows_;
+      ++batch_count_;
+      if ((batch_rows_ && batch_count_ >= batch_rows_) || (batch_bytes_ && batch_size_ >= batch_bytes_)) {
+        if (commit() != SQLITE_OK) {
+          throw database_error(cmd_.db_);
+        }
+      }
+    }
+
+    template <class... Ts>
+    void insert(std::tuple<Ts...> const& row) {
+      insert_tuple(row, typename make_index_sequence<sizeof...(Ts)>::type());
+    }
+
+    template <class Range>
+    void insert_all(Range const& rows) {
+      for (auto const& row : rows) {
+        insert(row);
+      }
+    }
+
+    int commit();
+    int finish();
+
+    unsigned long long rows() const;
+    unsigned long long bytes() const;
+    double elapsed() const;
+    double rows_per_sec() const;
+
+   private:
+    template <class... Ts, std::size_t... Is>
+    void insert_tuple(std::tuple<Ts...> const& row, index_sequence<Is...>) {
+      insert(std::get<Is>(row)...);
+    }
+
+    int bind_values(int /*idx*/) { return SQLITE_OK; }
+
+    template <class T, class... Ts>
+    int bind_values(int idx, T const& value, Ts const&... values) {
+      auto rc = bind_value(idx, value);
+      return rc == SQLITE_OK ? bind_values(idx + 1, values...) : rc;
+    }
+
+    // Values bind as statement::bind_arg binds them; only their size is
+    // counted here.
+    template <class T>
+    int bind_value(int idx, T const& value) {
+      auto n = value_size(value);
+      batch_size_ += n;
+      bytes_ += n;
+      return cmd_.bind_arg(idx, value);
+    }
+
+    template <class T>
+    static typename std::enable_if<std::is_arithmetic<T>::value, std::size_t>::type value_size(T) {
+      return sizeof(T);
+    }
+
+    static std::size_t value_size(char const* value);
+    static std::size_t value_size(std::string const& value);
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+    static std::size_t value_size(std::string_view value);
+#endif
+    static std::size_t value_size(blob_view value);
+    static std::size_t value_size(null_type);
+
+    void discard_row();
+    void begin();
+    void restore();
+
+   private:
+    command& cmd_;
+    std::size_t batch_rows_;
+    std::size_t batch_bytes_;
+    std::size_t batch_count_;
+    std::size_t batch_size_;
+    unsigned long long rows_;
+    unsigned long long bytes_;
+    std::unique_ptr<transaction> xct_;
+    bool ffast_;
+    int synchronous_;
+    std::string journal_mode_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
+  // Collects timings and sqlite3_stmt_status() counters per SQL text through
+  // the trace handler of db, which it owns while enabled. A run is timed
+  // from its first step until the statement is reset or finalized. Rows
+  // aren't traced, so nothing is paid per row. snapshot() and reset() can
+  // be called from any thread.
+  class profiler : noncopyable
+  {
+   public:
+    // Bucket i counts runs that took [2^i, 2^(i+1)) microseconds. The first
+    // and the last buckets also count everything below and above.
+    static constexpr std::size_t buckets = 24;
+
+    struct entry
+    {
+      std::string sql;
+      unsigned long long runs = 0;
+      unsigned long long total_ns = 0;
+      unsigned long long max_ns = 0;
+      unsigned long long fullscan_steps = 0;
+      unsigned long long sorts = 0;
+      unsigned long long autoindexes = 0;
+      unsigned long long vm_steps = 0;
+      std::array<unsigned long long, buckets> histogram{};
+    };
+
+    explicit profiler(database& db, bool fenable = true);
+    ~profiler();
+
+    void enable();
+    void disable();
+    bool enabled() const;
+
+    // The entries with the largest total time come first.
+    std::vector<entry> snapshot() const;
+    void reset();
+
+   private:
+    int trace(unsigned int type, sqlite3_stmt* stmt, void* x);
+
+   private:
+    struct slot
+    {
+      entry* e = nullptr;
+      std::chrono::steady_clock::time_point start;
+      std::array<int, 4> status{};
+    };
+
+    database& db_;
+    std::atomic<bool> fenabled_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, entry> entries_;
+    std::unordered_map<sqlite3_stmt*, slot> stmts_;
+  };
+
 } // namespace sqlite3pp
 
 #include "sqlite3pp.ipp"
@@ -25,55 +25,24 @@
 #ifndef SQLITE3PPEXT_H
 #define SQLITE3PPEXT_H
 
+#include <atomic>
 #include <cstddef>
+#include <functional>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "sqlite3pp.h"
 
 namespace sqlite3pp
 {
-  namespace
-  {
-    template<size_t N>
-    struct Apply {
-      template<typename F, typename T, typename... A>
-      static inline auto apply(F&& f, T&& t, A&&... a)
-        -> decltype(Apply<N-1>::apply(std::forward<F>(f),
-                                      std::forward<T>(t),
-                                      std::get<N-1>(std::forward<T>(t)),
-                                      std::forward<A>(a)...))
-      {
-        return Apply<N-1>::apply(std::forward<F>(f),
-                                 std::forward<T>(t),
-                                 std::get<N-1>(std::forward<T>(t)),
-                                 std::forward<A>(a)...);
-      }
-    };
-
-    template<>
-    struct Apply<0> {
-      template<typename F, typename T, typename... A>
-      static inline auto apply(F&& f, T&&, A&&... a)
-        -> decltype(std::forward<F>(f)(std::forward<A>(a)...))
-      {
-        return std::forward<F>(f)(std::forward<A>(a)...);
-      }
-    };
-
-    template<typename F, typename T>
-    inline auto apply(F&& f, T&& t)
-      -> decltype(Apply<std::tuple_size<typename std::decay<T>::type>::value>::apply(std::forward<F>(f), std::forward<T>(t)))
-    {
-      return Apply<std::tuple_size<typename std::decay<T>::type>::value>::apply(
-          std::forward<F>(f), std::forward<T>(t));
-    }
-  }
-
-
   namespace ext
   {
 
@@ -94,6 +63,9 @@ namespace sqlite3pp
       void result(double value);
       void result(long long int value);
       void result(std::string const& value);
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+      void result(std::string_view value);
+#endif
       void result(char const* value, bool fcopy);
       void result(void const* value, int n, bool fcopy);
       void result();
@@ -116,6 +88,10 @@ namespace sqlite3pp
       char const* get(int idx, char const*) const;
       std::string get(int idx, std::string) const;
       void const* get(int idx, void const*) const;
+      blob_view get(int idx, blob_view) const;
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+      std::string_view get(int idx, std::string_view) const;
+#endif
 
       template<class H, class... Ts>
       static inline std::tuple<H, Ts...> to_tuple_impl(int index, const context& c, std::tuple<H, Ts...>&&)
@@ -136,12 +112,54 @@ namespace sqlite3pp
 
     namespace
     {
+      // Decodes each argument in place and calls f with them.
+      template <class... Ps>
+      struct invoker
+      {
+        template <class F, std::size_t... Is>
+        static void call(context& c, F f, index_sequence<Is...>) {
+          c.result(f(c.get<typename std::decay<Ps>::type>(static_cast<int>(Is))...));
+        }
+      };
+
+      template <class F>
+      struct call_traits;
+
+      template <class R, class... Ps>
+      struct call_traits<R (*)(Ps...)>
+      {
+        using invoker_type = invoker<Ps...>;
+        using indices = typename make_index_sequence<sizeof...(Ps)>::type;
+        static const int nargs = sizeof...(Ps);
+      };
+
+      template <class C, class R, class... Ps>
+      struct call_traits<R (C::*)(Ps...)> : call_traits<R (*)(Ps...)> {};
+
+      template <class C, class R, class... Ps>
+      struct call_traits<R (C::*)(Ps...) const> : call_traits<R (*)(Ps...)> {};
+
       template <class R, class... Ps>
       void functionx_impl(sqlite3_context* ctx, int nargs, sqlite3_value** values)
       {
         context c(ctx, nargs, values);
         auto f = static_cast<std::function<R (Ps...)>*>(sqlite3_user_data(ctx));
-        c.result(apply(*f, c.to_tuple<Ps...>()));
+        invoker<Ps...>::call(c, std::ref(*f), typename make_index_sequence<sizeof...(Ps)>::type());
+      }
+
+      template <class F, F f>
+      void functionp_impl(sqlite3_context* ctx, int nargs, sqlite3_value** values)
+      {
+        context c(ctx, nargs, values);
+        call_traits<F>::invoker_type::call(c, f, typename call_traits<F>::indices());
+      }
+
+      template <class T>
+      void functiont_impl(sqlite3_context* ctx, int nargs, sqlite3_value** values)
+      {
+        using traits = call_traits<decltype(&T::operator())>;
+        context c(ctx, nargs, values);
+        traits::invoker_type::call(c, T(), typename traits::indices());
       }
     }
 
@@ -153,11 +171,35 @@ namespace sqlite3pp
 
       explicit function(database& db);
 
-      int create(char const* name, function_handler h, int nargs = 0);
+      // flags can be SQLITE_DETERMINISTIC, SQLITE_INNOCUOUS or
+      // SQLITE_DIRECTONLY.
+      int create(char const* name, function_handler h, int nargs = 0, int flags = 0);
+
+      template <class F> int create(char const* name, std::function<F> h, int flags = 0) {
+        auto& fh = fh_[name];
+        fh = std::shared_ptr<void>(new std::function<F>(h));
+        return create_function_impl<F>()(db_, fh.get(), name, flags);
+      }
+
+      // f is called directly, without going through std::function, e.g.
+      // create<decltype(&f), &f>("f").
+      template <class F, F f> int create(char const* name, int flags = 0) {
+        return sqlite3_create_function(db_, name, call_traits<F>::nargs, SQLITE_UTF8 | flags, nullptr,
+                                       functionp_impl<F, f>,
+                                       0, 0);
+      }
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+      template <auto f> int create(char const* name, int flags = 0) {
+        return create<decltype(f), f>(name, flags);
+      }
+#endif
 
-      template <class F> int create(char const* name, std::function<F> h) {
-        fh_[name] = std::shared_ptr<void>(new std::function<F>(h));
-        return create_function_impl<F>()(db_, fh_[name].get(), name);
+      // T is a stateless callable type, default constructed for each call.
+      template <class T> int create(char const* name, int flags = 0) {
+        return sqlite3_create_function(db_, name, call_traits<decltype(&T::operator())>::nargs, SQLITE_UTF8 | flags, nullptr,
+                                       functiont_impl<T>,
+                                       0, 0);
       }
 
      private:
@@ -168,8 +210,8 @@ namespace sqlite3pp
       template<class R, class... Ps>
       struct create_function_impl<R (Ps...)>
       {
-        int operator()(sqlite3* db, void* fh, char const* name) {
-          return sqlite3_create_function(db, name, sizeof...(Ps), SQLITE_UTF8, fh,
+        int operator()(sqlite3* db, void* fh, char const* name, int flags) {
+          return sqlite3_create_function(db, name, sizeof...(Ps), SQLITE_UTF8 | flags, fh,
                                          functionx_impl<R, Ps...>,
                                          0, 0);
         }
@@ -183,24 +225,100 @@ namespace sqlite3pp
 
     namespace
     {
+      // The aggregate context holds a pointer to T followed by room for T
+      // at its own alignment. The pointer is null until the first step()
+      // constructs T, and T is never moved after that.
+      template <class T>
+      T* aggregate_object(sqlite3_context* ctx, bool fcreate)
+      {
+        std::size_t const size = sizeof(T*) + sizeof(T) + alignof(T) - 1;
+        auto p = static_cast<T**>(sqlite3_aggregate_context(ctx, fcreate ? static_cast<int>(size) : 0));
+        if (p && !*p && fcreate) {
+          void* buf = p + 1;
+          std::size_t space = size - sizeof(T*);
+          *p = new (std::align(alignof(T), sizeof(T), buf, space)) T;
+        }
+        return p ? *p : nullptr;
+      }
+
+      template <class T, class... Ps>
+      struct aggregate_invoker
+      {
+        template <std::size_t... Is>
+        static void step(context& c, T* t, index_sequence<Is...>) {
+          t->step(c.get<typename std::decay<Ps>::type>(static_cast<int>(Is))...);
+        }
+
+        template <std::size_t... Is>
+        static void inverse(context& c, T* t, index_sequence<Is...>) {
+          t->inverse(c.get<typename std::decay<Ps>::type>(static_cast<int>(Is))...);
+        }
+      };
+
       template <class T, class... Ps>
       void stepx_impl(sqlite3_context* ctx, int nargs, sqlite3_value** values)
       {
+        T* t = aggregate_object<T>(ctx, true);
+        if (!t) {
+          sqlite3_result_error_nomem(ctx);
+          return;
+        }
         context c(ctx, nargs, values);
-        T* t = static_cast<T*>(c.aggregate_data(sizeof(T)));
-        if (c.aggregate_count() == 1) new (t) T;
-        apply([](T* tt, Ps... ps){tt->step(ps...);},
-              std::tuple_cat(std::make_tuple(t), c.to_tuple<Ps...>()));
+        aggregate_invoker<T, Ps...>::step(c, t, typename make_index_sequence<sizeof...(Ps)>::type());
       }
 
       template <class T>
       void finishN_impl(sqlite3_context* ctx)
       {
         context c(ctx);
-        T* t = static_cast<T*>(c.aggregate_data(sizeof(T)));
+        T* t = aggregate_object<T>(ctx, false);
+        if (!t) {
+          // No rows in the group.
+          T empty{};
+          c.result(empty.finish());
+          return;
+        }
         c.result(t->finish());
         t->~T();
       }
+
+      template <class T, class... Ps>
+      void inversex_impl(sqlite3_context* ctx, int nargs, sqlite3_value** values)
+      {
+        T* t = aggregate_object<T>(ctx, false);
+        if (!t)
+          return;
+        context c(ctx, nargs, values);
+        aggregate_invoker<T, Ps...>::inverse(c, t, typename make_index_sequence<sizeof...(Ps)>::type());
+      }
+
+      template <class T>
+      void valueN_impl(sqlite3_context* ctx)
+      {
+        context c(ctx);
+        T* t = aggregate_object<T>(ctx, false);
+        if (!t) {
+          // The frame is empty.
+          T empty{};
+          c.result(empty.value());
+          return;
+        }
+        c.result(t->value());
+      }
+
+      // True if T has inverse(Ps...) and value(), so that it can be used as
+      // a window function.
+      template <class T, class... Ps>
+      struct is_window_aggregate
+      {
+        template <class U>
+        static auto test(int) -> decltype(std::declval<U&>().inverse(std::declval<Ps>()...), std::declval<U&>().value(), std::true_type());
+
+        template <class U>
+        static std::false_type test(...);
+
+        using type = decltype(test<T>(0));
+      };
     }
 
     class aggregate : noncopyable
@@ -213,17 +331,476 @@ namespace sqlite3pp
 
       int create(char const* name, function_handler s, function_handler f, int nargs = 1);
 
+      // If T also has inverse(Ps...) and value(), it's registered as an
+      // aggregate window function, which SQLite can slide over a frame
+      // instead of aggregating the whole frame again for every row.
       template <class T, class... Ps>
       int create(char const* name) {
-        return sqlite3_create_function(db_, name, sizeof...(Ps), SQLITE_UTF8, 0, 0, stepx_impl<T, Ps...>, finishN_impl<T>);
+        return create_impl<T, Ps...>(name, typename is_window_aggregate<T, Ps...>::type());
       }
 
     private:
+      template <class T, class... Ps>
+      int create_impl(char const* name, std::false_type) {
+        return sqlite3_create_function(db_, name, sizeof...(Ps), SQLITE_UTF8, 0, 0, stepx_impl<T, Ps...>, finishN_impl<T>);
+      }
+
+      template <class T, class... Ps>
+      int create_impl(char const* name, std::true_type) {
+#if SQLITE_VERSION_NUMBER >= 3025000
+        return sqlite3_create_window_function(db_, name, sizeof...(Ps), SQLITE_UTF8, 0, stepx_impl<T, Ps...>, finishN_impl<T>, valueN_impl<T>, inversex_impl<T, Ps...>, 0);
+#else
+        return create_impl<T, Ps...>(name, std::false_type());
+#endif
+      }
+
       sqlite3* db_;
 
       std::map<std::string, std::pair<pfunction_base, pfunction_base> > ah_;
     };
 
+    // What xBestIndex gets from SQLite: the WHERE constraints and ORDER BY
+    // terms on a virtual table. A table picks the constraints it can seek
+    // on with use(); their values are passed to its cursor's filter() in
+    // the order they were used.
+    class index_info
+    {
+     public:
+      explicit index_info(sqlite3_index_info* info);
+
+      int constraint_count() const;
+      int constraint_column(int i) const;
+      int constraint_op(int i) const;
+      bool constraint_usable(int i) const;
+      void use(int i, bool fomit = true);
+
+      int orderby_count() const;
+      int orderby_column(int i) const;
+      bool orderby_desc(int i) const;
+      void set_ordered();
+
+      void set_index(int num);
+      void set_cost(double cost);
+      void set_rows(long long int rows);
+
+      // Tells SQLite this combination of usable constraints can't be
+      // planned, e.g. a table-valued function argument that isn't known yet.
+      void reject();
+      bool rejected() const;
+
+     private:
+      sqlite3_index_info* info_;
+      int nargs_;
+      bool frejected_;
+    };
+
+    namespace
+    {
+      template <class T>
+      struct has_best_index
+      {
+        template <class U>
+        static auto test(int) -> decltype(std::declval<U const&>().best_index(std::declval<index_info&>()), std::true_type());
+
+        template <class U>
+        static std::false_type test(...);
+
+        using type = decltype(test<T>(0));
+      };
+
+      template <class T>
+      struct vtable_impl
+      {
+        struct table : sqlite3_vtab
+        {
+          T* t;
+        };
+
+        // xEof can't report an error, so eof() is asked in filter() and
+        // next(), which can.
+        struct cursor : sqlite3_vtab_cursor
+        {
+          explicit cursor(T& t) : c(t), feof(true) {}
+          typename T::cursor c;
+          bool feof;
+        };
+
+        static int error(sqlite3_vtab* vt, char const* msg) {
+          sqlite3_free(vt->zErrMsg);
+          vt->zErrMsg = sqlite3_mprintf("%s", msg);
+          return SQLITE_ERROR;
+        }
+
+        static int connect(sqlite3* db, void* aux, int, char const* const*, sqlite3_vtab** vt, char**) {
+          auto t = static_cast<T*>(aux);
+          auto rc = sqlite3_declare_vtab(db, t->schema());
+          if (rc != SQLITE_OK)
+            return rc;
+          auto p = new (std::nothrow) table();
+          if (!p)
+            return SQLITE_NOMEM;
+          p->t = t;
+          *vt = p;
+          return SQLITE_OK;
+        }
+
+        static int disconnect(sqlite3_vtab* vt) {
+          delete static_cast<table*>(vt);
+          return SQLITE_OK;
+        }
+
+        static void best_index(T const&, index_info&, std::false_type) {
+        }
+
+        static void best_index(T const& t, index_info& info, std::true_type) {
+          t.best_index(info);
+        }
+
+        static int best_index(sqlite3_vtab* vt, sqlite3_index_info* p) {
+          try {
+            index_info info(p);
+            best_index(*static_cast<table*>(vt)->t, info, typename has_best_index<T>::type());
+            return info.rejected() ? SQLITE_CONSTRAINT : SQLITE_OK;
+          }
+          catch (std::exception& ex) {
+            return error(vt, ex.what());
+          }
+        }
+
+        static int open(sqlite3_vtab* vt, sqlite3_vtab_cursor** cur) {
+          try {
+            *cur = new cursor(*static_cast<table*>(vt)->t);
+            return SQLITE_OK;
+          }
+          catch (std::exception& ex) {
+            return error(vt, ex.what());
+          }
+        }
+
+        static int close(sqlite3_vtab_cursor* cur) {
+          delete static_cast<cursor*>(cur);
+          return SQLITE_OK;
+        }
+
+        static int filter(sqlite3_vtab_cursor* cur, int idxnum, char const*, int argc, sqlite3_value** argv) {
+          try {
+            context args(nullptr, argc, argv);
+            auto p = static_cast<cursor*>(cur);
+            p->c.filter(idxnum, args);
+            p->feof = p->c.eof();
+            return SQLITE_OK;
+          }
+          catch (std::exception& ex) {
+            return error(cur->pVtab, ex.what());
+          }
+        }
+
+        static int next(sqlite3_vtab_cursor* cur) {
+          try {
+            auto p = static_cast<cursor*>(cur);
+            p->c.next();
+            p->feof = p->c.eof();
+            return SQLITE_OK;
+          }
+          catch (std::exception& ex) {
+            return error(cur->pVtab, ex.what());
+          }
+        }
+
+        static int eof(sqlite3_vtab_cursor* cur) {
+          return static_cast<cursor*>(cur)->feof ? 1 : 0;
+        }
+
+        static int column(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col) {
+          try {
+            context c(ctx);
+            static_cast<cursor*>(cur)->c.column(c, col);
+            return SQLITE_OK;
+          }
+          catch (std::exception& ex) {
+            return error(cur->pVtab, ex.what());
+          }
+        }
+
+        static int rowid(sqlite3_vtab_cursor* cur, sqlite3_int64* rowid) {
+          try {
+            *rowid = static_cast<cursor*>(cur)->c.rowid();
+            return SQLITE_OK;
+          }
+          catch (std::exception& ex) {
+            return error(cur->pVtab, ex.what());
+          }
+        }
+
+        static sqlite3_module const* module() {
+          static sqlite3_module const m = [] {
+            // Without xCreate, the module is eponymous-only.
+            sqlite3_module m = {};
+            m.xConnect = connect;
+            m.xBestIndex = best_index;
+            m.xDisconnect = disconnect;
+            m.xOpen = open;
+            m.xClose = close;
+            m.xFilter = filter;
+            m.xNext = next;
+            m.xEof = eof;
+            m.xColumn = column;
+            m.xRowid = rowid;
+            return m;
+          }();
+          return &m;
+        }
+      };
+    }
+
+    // A read-only virtual table over a C++ object. T has
+    //   char const* schema() const;  // "CREATE TABLE x(a, b, arg HIDDEN)"
+    //   void best_index(index_info& info) const;  // optional
+    // and a nested cursor type constructible from T& with
+    //   void filter(int idxnum, context& args);
+    //   void next();
+    //   bool eof() const;
+    //   void column(context& c, int col) const;
+    //   long long int rowid() const;
+    // The module is eponymous, so the table can be queried by its name, or
+    // called as a table-valued function with its HIDDEN columns as
+    // arguments. It is eponymous-only, so CREATE VIRTUAL TABLE ... USING
+    // name fails. t must outlive db.
+    template <class T>
+    class vtable : noncopyable
+    {
+     public:
+      explicit vtable(database& db) : db_(db.db_) {}
+
+      int create(char const* name, T& t) {
+        return sqlite3_create_module_v2(db_, name, vtable_impl<T>::module(), &t, nullptr);
+      }
+
+     private:
+      sqlite3* db_;
+    };
+
+#ifdef SQLITE_ENABLE_SESSION
+    // Changes recorded by a session, or received from another database. It
+    // holds memory from sqlite3_malloc(). A patchset is kept in the same
+    // type and can be iterated and applied, but not inverted.
+    class changeset : noncopyable
+    {
+      friend class session;
+
+     public:
+      // One changed row. It is good until the iteration moves on.
+      class change
+      {
+        friend class changeset;
+
+       public:
+        char const* table() const;
+        int op() const;  // SQLITE_INSERT, SQLITE_UPDATE or SQLITE_DELETE
+        bool indirect() const;
+        int column_count() const;
+
+        // Null for the side an op doesn't have, and for the columns an
+        // UPDATE leaves alone.
+        sqlite3_value* old_value(int idx) const;
+        sqlite3_value* new_value(int idx) const;
+
+        // The row in the target database, in a conflict handler.
+        sqlite3_value* conflict_value(int idx) const;
+
+        template <class T> T get_old(int idx) const {
+          return get(old_value(idx), T());
+        }
+        template <class T> T get_new(int idx) const {
+          return get(new_value(idx), T());
+        }
+
+       private:
+        explicit change(sqlite3_changeset_iter* it = nullptr);
+
+        static int get(sqlite3_value* v, int);
+        static double get(sqlite3_value* v, double);
+        static long long int get(sqlite3_value* v, long long int);
+        static char const* get(sqlite3_value* v, char const*);
+        static std::string get(sqlite3_value* v, std::string);
+        static blob_view get(sqlite3_value* v, blob_view);
+
+       private:
+        sqlite3_changeset_iter* it_;
+        char const* table_;
+        int ncols_;
+        int op_;
+        int indirect_;
+      };
+
+      class iterator
+      {
+       public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = change;
+        using difference_type = std::ptrdiff_t;
+        using pointer = change const*;
+        using reference = change const&;
+
+        iterator();
+        explicit iterator(changeset const* cs);
+
+        bool operator==(iterator const& other) const;
+        bool operator!=(iterator const& other) const;
+
+        iterator& operator++();
+
+        reference operator*() const;
+        pointer operator->() const;
+
+       private:
+        std::shared_ptr<sqlite3_changeset_iter> it_;
+        change c_;
+      };
+
+      // Returns SQLITE_CHANGESET_OMIT, SQLITE_CHANGESET_REPLACE or
+      // SQLITE_CHANGESET_ABORT for a conflict of type SQLITE_CHANGESET_*.
+      using conflict_handler = std::function<int (int, change const&)>;
+      using filter_handler = std::function<bool (char const*)>;
+
+      changeset();
+      // Copies n bytes at data. Throws std::bad_alloc if it can't.
+      changeset(void const* data, int n);
+      changeset(changeset&& cs);
+      changeset& operator=(changeset&& cs);
+      ~changeset();
+
+      void const* data() const;
+      int size() const;
+      bool empty() const;
+
+      // Throws database_error if the changeset is corrupt.
+      iterator begin() const;
+      iterator end() const;
+
+      int invert(changeset& out) const;
+      int concat(changeset const& other, changeset& out) const;
+
+      // Applies the changes to db, in a transaction. Without h, the first
+      // conflict aborts and rolls back everything. Only the tables f
+      // accepts are changed, if f is given.
+      int apply(database& db, conflict_handler h = {}, filter_handler f = {}) const;
+
+     private:
+      static int conflict_impl(void* p, int type, sqlite3_changeset_iter* it);
+      void clear();
+
+     private:
+      void* data_;
+      int size_;
+    };
+
+    // Records the changes made through db to tables with a primary key. It
+    // has to be destroyed before db is closed.
+    class session : noncopyable
+    {
+     public:
+      explicit session(database& db, char const* dbname = "main");
+      ~session();
+
+      // Records the changes to table, or to every table if it's null.
+      int attach(char const* table = nullptr);
+
+      void enable(bool fenable = true);
+      bool enabled() const;
+      bool empty() const;
+
+      int changeset(ext::changeset& cs) const;
+      int patchset(ext::changeset& cs) const;
+
+     private:
+      sqlite3_session* s_;
+    };
+#endif
+
+    // A VFS that forwards everything to another VFS, the default one if
+    // base is null. It is registered by the constructor and unregistered by
+    // the destructor, so it has to outlive the databases that use it. A
+    // subclass overrides open() to wrap files in a file subclass of its own.
+    class vfs : noncopyable
+    {
+      friend struct vfs_impl;
+
+     public:
+      // An open file. The methods forward to the file of the base VFS, and
+      // must not throw.
+      class file : noncopyable
+      {
+       public:
+        explicit file(sqlite3_file* base);
+        virtual ~file();
+
+        virtual int close();
+        virtual int read(void* data, int n, sqlite3_int64 off);
+        virtual int write(void const* data, int n, sqlite3_int64 off);
+        virtual int truncate(sqlite3_int64 size);
+        virtual int sync(int flags);
+        virtual int file_size(sqlite3_int64& size);
+        virtual int lock(int level);
+        virtual int unlock(int level);
+        virtual int check_reserved_lock(int& reserved);
+        virtual int file_control(int op, void* arg);
+        virtual int sector_size();
+        virtual int device_characteristics();
+        virtual int shm_map(int region, int size, bool fextend, void volatile** pp);
+        virtual int shm_lock(int offset, int n, int flags);
+        virtual void shm_barrier();
+        virtual int shm_unmap(bool fdelete);
+        virtual int fetch(sqlite3_int64 off, int n, void** pp);
+        virtual int unfetch(sqlite3_int64 off, void* p);
+
+       protected:
+        sqlite3_file* base_;
+      };
+
+      // Throws database_error if there is no base VFS or it can't be registered.
+      explicit vfs(char const* name, char const* base = nullptr, bool fdefault = false);
+      virtual ~vfs();
+
+      char const* name() const;
+
+     protected:
+      // Called for each file the base VFS has opened as base. name is null
+      // for temporary files, and flags are the SQLITE_OPEN_* flags.
+      virtual std::unique_ptr<file> open(char const* name, int flags, sqlite3_file* base);
+
+     private:
+      std::string name_;
+      sqlite3_vfs* base_;
+      sqlite3_vfs vfs_;
+    };
+
+    // Serves sequential reads of main database files from a buffer filled
+    // by one read of readahead bytes, instead of a read per page. The buffer
+    // is dropped whenever the file is written, truncated, locked, unlocked
+    // or has its WAL index locked, so it never outlives the transaction
+    // that filled it.
+    class readahead_vfs : public vfs
+    {
+     public:
+      explicit readahead_vfs(char const* name, std::size_t readahead = 1024 * 1024, char const* base = nullptr, bool fdefault = false);
+
+      // Reads served from a buffer, and reads that filled one.
+      unsigned long long hits() const;
+      unsigned long long fills() const;
+
+     protected:
+      std::unique_ptr<file> open(char const* name, int flags, sqlite3_file* base) override;
+
+     private:
+      class readahead_file;
+
+     private:
+      std::size_t readahead_;
+      std::atomic<unsigned long long> hits_;
+      std::atomic<unsigned long long> fills_;
+    };
+
   } // namespace ext
 
 } // namespace sqlite3pp
@@ -0,0 +1,810 @@
+// sqlite3ppthread.ipp
+//
+// The MIT License
+//
+// Copyright (c) 2015 Wongoo Lee (iwongu at gmail dot com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+namespace sqlite3pp
+{
+
+  inline connection_pool::lease::lease(connection_pool* pool, std::size_t slot) : pool_(pool), slot_(slot)
+  {
+  }
+
+  inline connection_pool::lease::lease(lease&& l) : pool_(l.pool_), slot_(l.slot_)
+  {
+    l.pool_ = nullptr;
+  }
+
+  inline connection_pool::lease& connection_pool::lease::operator=(lease&& l)
+  {
+    release();
+
+    pool_ = l.pool_;
+    slot_ = l.slot_;
+    l.pool_ = nullptr;
+
+    return *this;
+  }
+
+  inline connection_pool::lease::~lease()
+  {
+    release();
+  }
+
+  inline database& connection_pool::lease::db() const
+  {
+    return pool_->slots_[slot_]->db;
+  }
+
+  inline database& connection_pool::lease::operator*() const
+  {
+    return db();
+  }
+
+  inline database* connection_pool::lease::operator->() const
+  {
+    return &db();
+  }
+
+  inline void connection_pool::lease::release()
+  {
+    if (pool_) {
+      pool_->release(slot_);
+      pool_ = nullptr;
+    }
+  }
+
+  inline connection_pool::connection_pool(char const* dbname, std::size_t nreaders, std::size_t cache_capacity, int busy_timeout, char const* vfs)
+  {
+    // Slot 0 is the writer. It is opened first so that the file exists and
+    // is in WAL mode before the readers open it.
+    for (std::size_t i = 0; i <= nreaders; ++i) {
+      auto flags = (i == 0 ? SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE : SQLITE_OPEN_READONLY) | SQLITE_OPEN_NOMUTEX;
+      std::unique_ptr<slot> s(new slot{database(dbname, flags, vfs), false, std::thread::id()});
+      s->db.set_busy_timeout(busy_timeout);
+      s->db.stmt_cache().set_capacity(cache_capacity);
+      if (i == 0) {
+        query qry(s->db, "PRAGMA journal_mode=WAL");
+        auto mode = (*qry.begin()).get<std::string>(0);
+        if (mode != "wal")
+          throw database_error("can't enable WAL mode");
+      }
+      slots_.push_back(std::move(s));
+    }
+  }
+
+  inline connection_pool::~connection_pool()
+  {
+  }
+
+  inline connection_pool::lease connection_pool::reader()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    auto id = std::this_thread::get_id();
+    for (;;) {
+      auto found = slots_.size();
+      for (std::size_t i = 1; i < slots_.size(); ++i) {
+        if (slots_[i]->busy) continue;
+        if (slots_[i]->owner == id) {
+          found = i;
+          break;
+        }
+        if (found == slots_.size()) found = i;
+      }
+      if (found != slots_.size()) {
+        slots_[found]->busy = true;
+        slots_[found]->owner = id;
+        return lease(this, found);
+      }
+      readers_cv_.wait(lock);
+    }
+  }
+
+  inline connection_pool::lease connection_pool::writer()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    writer_cv_.wait(lock, [this] { return !slots_[0]->busy; });
+    slots_[0]->busy = true;
+    slots_[0]->owner = std::this_thread::get_id();
+    return lease(this, 0);
+  }
+
+  inline std::size_t connection_pool::readers() const
+  {
+    return slots_.size() - 1;
+  }
+
+  inline void connection_pool::release(std::size_t slot)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      slots_[slot]->busy = false;
+    }
+    if (slot == 0) {
+      writer_cv_.notify_one();
+    }
+    else {
+      readers_cv_.notify_one();
+    }
+  }
+
+
+  inline backup_thread::backup_thread(backup_job& job) : job_(job), running_(true), rc_(SQLITE_OK)
+  {
+    thread_ = std::thread([this] {
+      rc_ = job_.run();
+      running_ = false;
+    });
+  }
+
+  inline backup_thread::~backup_thread()
+  {
+    if (thread_.joinable()) {
+      job_.cancel();
+      thread_.join();
+    }
+  }
+
+  inline int backup_thread::wait()
+  {
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+    return rc_;
+  }
+
+  inline void backup_thread::cancel()
+  {
+    job_.cancel();
+  }
+
+  inline bool backup_thread::running() const
+  {
+    return running_;
+  }
+
+
+  inline write_scheduler::write_scheduler(database& db, std::size_t max_batch, std::chrono::milliseconds max_delay) :
+    db_(db), max_batch_(max_batch ? max_batch : 1), max_delay_(max_delay), stop_(false), batches_(0), jobs_(0)
+  {
+    thread_ = std::thread([this] { run(); });
+  }
+
+  inline write_scheduler::~write_scheduler()
+  {
+    stop();
+  }
+
+  inline std::future<int> write_scheduler::submit(job j)
+  {
+    item it;
+    it.j = std::move(j);
+    auto f = it.p.get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stop_) {
+        it.p.set_value(SQLITE_MISUSE);
+        return f;
+      }
+      queue_.push_back(std::move(it));
+    }
+    cv_.notify_one();
+    return f;
+  }
+
+  inline std::future<int> write_scheduler::submit(command& cmd)
+  {
+    return submit([&cmd](database&) {
+      auto rc = cmd.execute();
+      cmd.reset();
+      return rc;
+    });
+  }
+
+  inline void write_scheduler::stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  inline unsigned long long write_scheduler::batches() const
+  {
+    return batches_;
+  }
+
+  inline unsigned long long write_scheduler::jobs() const
+  {
+    return jobs_;
+  }
+
+  inline void write_scheduler::run()
+  {
+    std::vector<item> batch;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (queue_.empty())
+          return;
+
+        if (max_delay_.count() > 0 && !stop_) {
+          cv_.wait_for(lock, max_delay_, [this] { return stop_ || queue_.size() >= max_batch_; });
+        }
+
+        auto n = std::min(queue_.size(), max_batch_);
+        for (std::size_t i = 0; i < n; ++i) {
+          batch.push_back(std::move(queue_.front()));
+          queue_.pop_front();
+        }
+      }
+
+      run_batch(batch);
+      batch.clear();
+    }
+  }
+
+  inline void write_scheduler::run_batch(std::vector<item>& batch)
+  {
+    std::vector<int> rcs(batch.size(), SQLITE_OK);
+    std::vector<std::exception_ptr> errors(batch.size());
+
+    auto rc = SQLITE_OK;
+    try {
+      transaction xct(db_, transaction_mode::immediate);
+
+      for (std::size_t i = 0; i < batch.size(); ++i) {
+        try {
+          savepoint sp(db_);
+          rcs[i] = batch[i].j(db_);
+          if (rcs[i] == SQLITE_OK || rcs[i] == SQLITE_DONE) {
+            sp.release();
+          }
+        }
+        catch (...) {
+          errors[i] = std::current_exception();
+        }
+      }
+
+      rc = xct.commit();
+      if (rc != SQLITE_OK) {
+        db_.execute("ROLLBACK");
+      }
+    }
+    catch (...) {
+      // BEGIN failed, so none of the jobs ran.
+      auto e = std::current_exception();
+      for (auto& error : errors) {
+        error = e;
+      }
+    }
+
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      if (errors[i]) {
+        batch[i].p.set_exception(errors[i]);
+      }
+      else {
+        batch[i].p.set_value(rc != SQLITE_OK ? rc : rcs[i]);
+      }
+    }
+
+    ++batches_;
+    jobs_ += batch.size();
+  }
+
+
+  inline change_feed::change_feed(database& db, consumer c, std::size_t capacity, std::size_t reserve) :
+    db_(db), c_(std::move(c)), ring_(capacity ? capacity : 1), head_(0), tail_(0), sleeping_(false), blocked_(false), stop_(false),
+    batches_(0), changes_(0), stalls_(0)
+  {
+    pending_.reserve(reserve);
+    for (auto& b : ring_) {
+      b.reserve(reserve);
+    }
+
+    db_.set_update_handler([this](int op, char const* dbname, char const* table, long long int rowid) {
+      pending_.push_back(change{op, intern(dbname), intern(table), rowid});
+    });
+    db_.set_commit_handler([this] {
+      publish();
+      return 0;
+    });
+    db_.set_rollback_handler([this] {
+      pending_.clear();
+    });
+
+    thread_ = std::thread([this] { run(); });
+  }
+
+  inline change_feed::~change_feed()
+  {
+    db_.set_update_handler(database::update_handler());
+    db_.set_commit_handler(database::commit_handler());
+    db_.set_rollback_handler(database::rollback_handler());
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+  }
+
+  inline unsigned long long change_feed::batches() const
+  {
+    return batches_;
+  }
+
+  inline unsigned long long change_feed::changes() const
+  {
+    return changes_;
+  }
+
+  inline unsigned long long change_feed::stalls() const
+  {
+    return stalls_;
+  }
+
+  inline char const* change_feed::intern(char const* name)
+  {
+    // A transaction touches few tables, so a scan from the newest name
+    // beats hashing the name for every row.
+    for (auto it = names_.rbegin(); it != names_.rend(); ++it) {
+      if (std::strcmp(it->c_str(), name) == 0) {
+        return it->c_str();
+      }
+    }
+    names_.push_back(name);
+    return names_.back().c_str();
+  }
+
+  inline void change_feed::publish()
+  {
+    if (pending_.empty())
+      return;
+
+    auto h = head_.load(std::memory_order_relaxed);
+    if (h - tail_.load(std::memory_order_acquire) >= ring_.size()) {
+      // The writer holds the write lock here, so it sleeps rather than
+      // spins. Pairs with run() like sleeping_ does the other way.
+      ++stalls_;
+      std::unique_lock<std::mutex> lock(mutex_);
+      blocked_ = true;
+      cv_.wait(lock, [&] { return h - tail_.load() < ring_.size(); });
+      blocked_ = false;
+    }
+
+    // The slot gets the changes, and the writer keeps the slot's emptied
+    // buffer, so no memory is allocated once the buffers have grown.
+    auto n = pending_.size();
+    ring_[h % ring_.size()].swap(pending_);
+    pending_.clear();
+    head_.store(h + 1);
+
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    changes_.fetch_add(n, std::memory_order_relaxed);
+
+    // Pairs with run(). Either the consumer sees the new head before it
+    // waits, or the writer sees that it has to wake it.
+    if (sleeping_.load()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv_.notify_all();
+    }
+  }
+
+  inline void change_feed::run()
+  {
+    for (;;) {
+      auto t = tail_.load(std::memory_order_relaxed);
+      if (head_.load() == t) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        sleeping_ = true;
+        cv_.wait(lock, [&] { return head_.load() != t || stop_; });
+        sleeping_ = false;
+        if (head_.load() == t)
+          return;
+        continue;
+      }
+
+      auto& b = ring_[t % ring_.size()];
+      try {
+        c_(b);
+      }
+      catch (...) {
+        // A consumer that throws loses only that batch.
+      }
+      b.clear();
+      tail_.store(t + 1);
+
+      if (blocked_.load()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_all();
+      }
+    }
+  }
+
+
+  inline shard_set::shard_set(std::vector<std::string> const& files, std::size_t nthreads, std::size_t cache_capacity, int flags, char const* vfs) : stop_(false)
+  {
+    for (auto const& file : files) {
+      std::unique_ptr<slot> s(new slot{database(file.c_str(), flags | SQLITE_OPEN_NOMUTEX, vfs), {}});
+      s->db.stmt_cache().set_capacity(cache_capacity);
+      shards_.push_back(std::move(s));
+    }
+
+    if (nthreads == 0) {
+      nthreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    nthreads = std::max<std::size_t>(1, std::min(nthreads, shards_.size()));
+    for (std::size_t i = 0; i < nthreads; ++i) {
+      threads_.push_back(std::thread([this] { loop(); }));
+    }
+  }
+
+  inline shard_set::~shard_set()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : threads_) {
+      t.join();
+    }
+  }
+
+  inline std::size_t shard_set::size() const
+  {
+    return shards_.size();
+  }
+
+  inline database& shard_set::shard(std::size_t i)
+  {
+    return shards_[i]->db;
+  }
+
+  inline void shard_set::for_each(std::function<void (database&, std::size_t)> f)
+  {
+    std::vector<std::exception_ptr> errors(shards_.size());
+    std::mutex m;
+    std::condition_variable done;
+    auto left = shards_.size();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (std::size_t i = 0; i < shards_.size(); ++i) {
+        queue_.push_back([&, i] {
+          try {
+            std::lock_guard<std::mutex> lock(shards_[i]->mutex);
+            f(shards_[i]->db, i);
+          }
+          catch (...) {
+            errors[i] = std::current_exception();
+          }
+          // Notified under the lock, since the waiter returns and takes
+          // done with it as soon as it sees left at 0.
+          std::lock_guard<std::mutex> lock(m);
+          --left;
+          done.notify_one();
+        });
+      }
+    }
+    cv_.notify_all();
+
+    std::unique_lock<std::mutex> lock(m);
+    done.wait(lock, [&] { return left == 0; });
+
+    for (auto const& error : errors) {
+      if (error)
+        std::rethrow_exception(error);
+    }
+  }
+
+  inline void shard_set::loop()
+  {
+    for (;;) {
+      std::function<void ()> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (queue_.empty())
+          return;
+        job = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      job();
+    }
+  }
+
+  inline busy_backoff::busy_backoff(std::chrono::microseconds initial, std::chrono::microseconds max_delay, std::chrono::milliseconds timeout) :
+    initial_(initial), max_delay_(max_delay), timeout_(timeout), contentions_(0), retries_(0), timeouts_(0), waited_(0)
+  {
+  }
+
+  inline int busy_backoff::operator()(int count)
+  {
+    // A thread waits for one lock at a time, so its wait started at its
+    // last call with count 0, whatever the connection.
+    static thread_local std::chrono::steady_clock::time_point start;
+    static thread_local std::minstd_rand rng(static_cast<std::minstd_rand::result_type>(std::hash<std::thread::id>()(std::this_thread::get_id())));
+
+    auto now = std::chrono::steady_clock::now();
+    if (count == 0) {
+      start = now;
+      ++contentions_;
+    }
+    auto left = std::chrono::duration_cast<std::chrono::microseconds>(timeout_ - (now - start));
+    if (left.count() <= 0) {
+      ++timeouts_;
+      return 0;
+    }
+
+    auto delay = std::min<std::chrono::microseconds>(max_delay_, initial_ * (1 << std::min(count, 20)));
+    // Half of the delay is kept, and the other half drawn at random.
+    auto half = delay.count() / 2;
+    delay = std::chrono::microseconds(half + std::uniform_int_distribution<long long int>(0, delay.count() - half)(rng));
+    delay = std::min(delay, left);
+
+    std::this_thread::sleep_for(delay);
+    ++retries_;
+    waited_ += delay.count();
+    return 1;
+  }
+
+  inline unsigned long long busy_backoff::contentions() const
+  {
+    return contentions_;
+  }
+
+  inline unsigned long long busy_backoff::retries() const
+  {
+    return retries_;
+  }
+
+  inline unsigned long long busy_backoff::timeouts() const
+  {
+    return timeouts_;
+  }
+
+  inline std::chrono::microseconds busy_backoff::waited() const
+  {
+    return std::chrono::microseconds(waited_.load());
+  }
+
+  inline checkpoint_scheduler::checkpoint_scheduler(database& db) : checkpoint_scheduler(db, options())
+  {
+  }
+
+  inline checkpoint_scheduler::checkpoint_scheduler(database& db, options const& opts) :
+    db_(db), opts_(opts), autocheckpoint_(0), pages_(0), due_(false), stop_(false), checkpoints_(0), restarts_(0), truncates_(0), busy_(0)
+  {
+    if (!*db_.filename())
+      throw database_error("checkpoint_scheduler: no database file");
+    sqlite3_vfs* vfs = nullptr;
+    sqlite3_file_control(db_.db_, "main", SQLITE_FCNTL_VFS_POINTER, &vfs);
+    if (ckptdb_.connect(db_.filename(), SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX, vfs ? vfs->zName : nullptr) != SQLITE_OK)
+      throw database_error(ckptdb_);
+    ckptdb_.set_busy_timeout(opts_.busy_timeout);
+    // The connection only finds the WAL once it has read the database.
+    if (ckptdb_.execute("PRAGMA schema_version") != SQLITE_OK)
+      throw database_error(ckptdb_);
+
+    // The WAL hook turns the automatic checkpoints off.
+    autocheckpoint_ = db_.tune().wal_autocheckpoint;
+    db_.set_wal_handler([this](char const* dbname, int pages) {
+      if (std::strcmp(dbname, "main") == 0) {
+        pages_ = pages;
+        if (pages >= opts_.passive_pages && !due_.exchange(true)) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          cv_.notify_one();
+        }
+      }
+      return SQLITE_OK;
+    });
+
+    thread_ = std::thread([this] { run(); });
+  }
+
+  inline checkpoint_scheduler::~checkpoint_scheduler()
+  {
+    db_.set_wal_handler(database::wal_handler());
+    database::options opts;
+    opts.wal_autocheckpoint = autocheckpoint_;
+    db_.tune(opts);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+  }
+
+  inline unsigned long long checkpoint_scheduler::checkpoints() const
+  {
+    return checkpoints_;
+  }
+
+  inline unsigned long long checkpoint_scheduler::restarts() const
+  {
+    return restarts_;
+  }
+
+  inline unsigned long long checkpoint_scheduler::truncates() const
+  {
+    return truncates_;
+  }
+
+  inline unsigned long long checkpoint_scheduler::busy() const
+  {
+    return busy_;
+  }
+
+  inline void checkpoint_scheduler::checkpoint()
+  {
+    int seen = pages_;
+    int log = -1, ckpt = -1;
+    auto rc = ckptdb_.checkpoint("main", SQLITE_CHECKPOINT_PASSIVE, &log, &ckpt);
+    ++checkpoints_;
+
+    if (rc == SQLITE_OK && ((ckpt < log && log >= opts_.restart_pages) || log >= opts_.truncate_pages)) {
+      auto truncate = log >= opts_.truncate_pages;
+      rc = ckptdb_.checkpoint("main", truncate ? SQLITE_CHECKPOINT_TRUNCATE : SQLITE_CHECKPOINT_RESTART, &log, &ckpt);
+      ++(truncate ? truncates_ : restarts_);
+    }
+
+    if (rc == SQLITE_BUSY)
+      ++busy_;
+    // Nothing is left for the timer, unless a commit came meanwhile.
+    else if (rc == SQLITE_OK && ckpt >= log)
+      pages_.compare_exchange_strong(seen, 0);
+  }
+
+  inline void checkpoint_scheduler::run()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+      auto ready = [this] { return stop_ || due_; };
+      if (opts_.interval.count() > 0)
+        cv_.wait_for(lock, opts_.interval, ready);
+      else
+        cv_.wait(lock, ready);
+      if (stop_)
+        break;
+      if (!due_.exchange(false) && pages_ == 0)
+        continue;
+
+      lock.unlock();
+      checkpoint();
+      lock.lock();
+    }
+  }
+
+  inline executor::executor(database& db, dispatcher dispatch) : db_(db), dispatch_(std::move(dispatch)), stop_(false)
+  {
+    thread_ = std::thread([this] { loop(); });
+  }
+
+  inline executor::~executor()
+  {
+    stop();
+  }
+
+  inline void executor::interrupt()
+  {
+    db_.interrupt();
+  }
+
+  inline void executor::stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+#ifdef SQLITE3PP_HAS_COROUTINES
+  inline awaitable<int> executor::execute(std::string sql)
+  {
+    return awaitable<int>(this, [sql](database& db) { return db.execute(sql.c_str()); });
+  }
+
+  inline awaitable<int> executor::execute(command& cmd)
+  {
+    return awaitable<int>(this, [&cmd](database&) {
+      auto rc = cmd.execute();
+      cmd.reset();
+      return rc;
+    });
+  }
+
+  inline awaitable<int> executor::commit(transaction& xct)
+  {
+    return awaitable<int>(this, [&xct](database&) { return xct.commit(); });
+  }
+#endif
+
+  inline void executor::enqueue(std::function<void ()> job)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stop_)
+        throw database_error("executor has stopped");
+      queue_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+  }
+
+  inline void executor::resume(std::function<void ()> r)
+  {
+    if (dispatch_) {
+      dispatch_(std::move(r));
+    }
+    else {
+      r();
+    }
+  }
+
+  inline void executor::loop()
+  {
+    for (;;) {
+      std::function<void ()> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (queue_.empty())
+          return;
+        job = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      job();
+    }
+  }
+
+#ifdef SQLITE3PP_HAS_COROUTINES
+  inline batch_reader::batch_reader(executor& ex, query& qry, std::size_t rows) : ex_(ex), qry_(qry), rows_(rows)
+  {
+  }
+
+  inline awaitable<bool> batch_reader::next()
+  {
+    return ex_.run(std::function<bool (database&)>([this](database&) { return qry_.fetch_batch(batch_, rows_) > 0; }));
+  }
+
+  inline column_batch const& batch_reader::batch() const
+  {
+    return batch_;
+  }
+#endif
+} // namespace sqlite3pp
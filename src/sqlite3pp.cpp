@@ -22,11 +22,23 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <memory>
+#include <new>
 
 #include "sqlite3pp.h"
 
+#ifdef SQLITE3PP_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace sqlite3pp
 {
 
@@ -64,9 +76,190 @@ namespace sqlite3pp
       return (*h)(evcode, p1, p2, dbname, tvname);
     }
 
+    int trace_impl(unsigned int type, void* p, void* x, void* y)
+    {
+      auto h = static_cast<database::trace_handler*>(p);
+      return (*h)(type, x, y);
+    }
+
+    int progress_handler_impl(void* p)
+    {
+      auto h = static_cast<database::progress_handler*>(p);
+      return (*h)();
+    }
+
+    int wal_hook_impl(void* p, sqlite3*, char const* dbname, int pages)
+    {
+      auto h = static_cast<database::wal_handler*>(p);
+      return (*h)(dbname, pages);
+    }
+
+    // Whether running stmt can make a later statement preparable. ATTACH is
+    // read-only to SQLite, but brings in a schema.
+    bool changes_schema(sqlite3_stmt* stmt)
+    {
+      if (!sqlite3_stmt_readonly(stmt))
+        return true;
+      auto sql = sqlite3_sql(stmt);
+      while (sql && std::isspace(static_cast<unsigned char>(*sql))) ++sql;
+      return sql && sqlite3_strnicmp(sql, "ATTACH", 6) == 0;
+    }
+
   } // namespace
 
-  database::database(char const* dbname, int flags, char const* vfs) : db_(nullptr)
+  statement_cache::statement_cache(std::size_t capacity) : capacity_(capacity), hits_(0), misses_(0), evictions_(0)
+  {
+  }
+
+  statement_cache::statement_cache(statement_cache&& sc) : capacity_(sc.capacity_),
+    lru_(std::move(sc.lru_)),
+    index_(std::move(sc.index_)),
+    hits_(sc.hits_),
+    misses_(sc.misses_),
+    evictions_(sc.evictions_)
+  {
+    sc.lru_.clear();
+    sc.index_.clear();
+  }
+
+  statement_cache& statement_cache::operator=(statement_cache&& sc)
+  {
+    clear();
+
+    // Whatever clear() left behind is still borrowed. Carry it over, so
+    // that its iterators stay valid until release() finalizes it.
+    sc.lru_.splice(sc.lru_.end(), lru_);
+
+    capacity_ = sc.capacity_;
+    lru_ = std::move(sc.lru_);
+    index_ = std::move(sc.index_);
+    hits_ = sc.hits_;
+    misses_ = sc.misses_;
+    evictions_ = sc.evictions_;
+
+    sc.lru_.clear();
+    sc.index_.clear();
+
+    return *this;
+  }
+
+  statement_cache::~statement_cache()
+  {
+    clear();
+  }
+
+  void statement_cache::set_capacity(std::size_t capacity)
+  {
+    capacity_ = capacity;
+    shrink(capacity_);
+  }
+
+  std::size_t statement_cache::capacity() const
+  {
+    return capacity_;
+  }
+
+  std::size_t statement_cache::size() const
+  {
+    return lru_.size();
+  }
+
+  unsigned long long statement_cache::hits() const
+  {
+    return hits_;
+  }
+
+  unsigned long long statement_cache::misses() const
+  {
+    return misses_;
+  }
+
+  unsigned long long statement_cache::evictions() const
+  {
+    return evictions_;
+  }
+
+  void statement_cache::clear()
+  {
+    // Statements still borrowed by a command or query can't be finalized
+    // yet. They are only taken out of the index, so that nobody else gets
+    // them, and are finalized when they come back.
+    for (auto it = lru_.begin(); it != lru_.end();) {
+      if (it->busy) {
+        unindex(it);
+        it->stale = true;
+        ++it;
+        continue;
+      }
+      it = erase(it);
+    }
+  }
+
+  bool statement_cache::acquire(std::string const& sql, unsigned int prepflags, entries::iterator& it)
+  {
+    auto range = index_.equal_range(sql);
+    for (auto i = range.first; i != range.second; ++i) {
+      if (!i->second->busy && i->second->prepflags == prepflags) {
+        it = i->second;
+        it->busy = true;
+        lru_.splice(lru_.begin(), lru_, it);
+        ++hits_;
+        return true;
+      }
+    }
+    ++misses_;
+    return false;
+  }
+
+  statement_cache::entries::iterator statement_cache::insert(std::string const& sql, unsigned int prepflags, sqlite3_stmt* stmt, std::size_t tail)
+  {
+    lru_.push_front(entry{sql, prepflags, stmt, tail, true, false});
+    index_.emplace(sql, lru_.begin());
+    shrink(capacity_);
+    return lru_.begin();
+  }
+
+  void statement_cache::release(entries::iterator it)
+  {
+    it->busy = false;
+    if (it->stale) {
+      sqlite3_finalize(it->stmt);
+      lru_.erase(it);
+      return;
+    }
+    shrink(capacity_);
+  }
+
+  statement_cache::entries::iterator statement_cache::erase(entries::iterator it)
+  {
+    unindex(it);
+    sqlite3_finalize(it->stmt);
+    return lru_.erase(it);
+  }
+
+  void statement_cache::unindex(entries::iterator it)
+  {
+    auto range = index_.equal_range(it->sql);
+    for (auto i = range.first; i != range.second; ++i) {
+      if (i->second == it) {
+        index_.erase(i);
+        break;
+      }
+    }
+  }
+
+  void statement_cache::shrink(std::size_t size)
+  {
+    auto it = lru_.end();
+    while (lru_.size() > size && it != lru_.begin()) {
+      --it;
+      if (it->busy) continue;
+      it = erase(it);
+      ++evictions_;
+    }
+  }
+
+  database::database(char const* dbname, int flags, char const* vfs) : db_(nullptr), spdepth_(0)
   {
     if (dbname) {
       auto rc = connect(dbname, flags, vfs);
@@ -75,14 +268,29 @@ namespace sqlite3pp
     }
   }
 
+  database::database(char const* dbname, options const& opts, int flags, char const* vfs) : db_(nullptr), spdepth_(0)
+  {
+    auto rc = connect(dbname, opts, flags, vfs);
+    if (rc != SQLITE_OK)
+      throw database_error("can't connect database");
+  }
+
   database::database(database&& db) : db_(std::move(db.db_)),
     bh_(std::move(db.bh_)),
     ch_(std::move(db.ch_)),
     rh_(std::move(db.rh_)),
     uh_(std::move(db.uh_)),
-    ah_(std::move(db.ah_))
+    ah_(std::move(db.ah_)),
+    th_(std::move(db.th_)),
+    ph_(std::move(db.ph_)),
+    wh_(std::move(db.wh_)),
+    sc_(std::move(db.sc_)),
+    xcts_(std::move(db.xcts_)),
+    spdepth_(db.spdepth_)
   {
     db.db_ = nullptr;
+    db.xcts_.clear();
+    db.spdepth_ = 0;
   }
 
   database& database::operator=(database&& db)
@@ -95,6 +303,19 @@ namespace sqlite3pp
     rh_ = std::move(db.rh_);
     uh_ = std::move(db.uh_);
     ah_ = std::move(db.ah_);
+    th_ = std::move(db.th_);
+    ph_ = std::move(db.ph_);
+    wh_ = std::move(db.wh_);
+
+    sc_ = std::move(db.sc_);
+
+    for (auto& x : xcts_) {
+      sqlite3_finalize(x.second);
+    }
+    xcts_ = std::move(db.xcts_);
+    db.xcts_.clear();
+    spdepth_ = db.spdepth_;
+    db.spdepth_ = 0;
 
     return *this;
   }
@@ -111,10 +332,29 @@ namespace sqlite3pp
     return sqlite3_open_v2(dbname, &db_, flags, vfs);
   }
 
+  int database::connect(char const* dbname, options const& opts, int flags, char const* vfs)
+  {
+    auto rc = connect(dbname, flags, vfs);
+    if (rc == SQLITE_OK && opts.lookaside_size > 0 && opts.lookaside_count > 0)
+      rc = sqlite3_db_config(db_, SQLITE_DBCONFIG_LOOKASIDE, nullptr, opts.lookaside_size, opts.lookaside_count);
+    if (rc == SQLITE_OK)
+      rc = tune(opts);
+    if (rc != SQLITE_OK)
+      disconnect();
+    return rc;
+  }
+
   int database::disconnect()
   {
     auto rc = SQLITE_OK;
     if (db_) {
+      sc_.clear();
+
+      for (auto& x : xcts_) {
+        sqlite3_finalize(x.second);
+      }
+      xcts_.clear();
+
       rc = sqlite3_close(db_);
       if (rc == SQLITE_OK) {
         db_ = nullptr;
@@ -145,15 +385,11 @@ namespace sqlite3pp
     if (!bkup) {
       return error_code();
     }
-    auto rc = SQLITE_OK;
-    do {
-      rc = sqlite3_backup_step(bkup, step_page);
-      if (h) {
-	h(sqlite3_backup_remaining(bkup), sqlite3_backup_pagecount(bkup), rc);
-      }
-    } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
-    sqlite3_backup_finish(bkup);
-    return rc;
+    backup_options opts;
+    opts.step_page = step_page;
+    opts.step_time = std::chrono::milliseconds(0);
+    backup_job job(bkup, h, opts);
+    return job.run();
   }
 
   void database::set_busy_handler(busy_handler h)
@@ -186,6 +422,24 @@ namespace sqlite3pp
     sqlite3_set_authorizer(db_, ah_ ? authorizer_impl : 0, &ah_);
   }
 
+  void database::set_trace_handler(unsigned int mask, trace_handler h)
+  {
+    th_ = h;
+    sqlite3_trace_v2(db_, th_ ? mask : 0, th_ ? trace_impl : 0, &th_);
+  }
+
+  void database::set_progress_handler(int n, progress_handler h)
+  {
+    ph_ = h;
+    sqlite3_progress_handler(db_, ph_ ? n : 0, ph_ ? progress_handler_impl : 0, &ph_);
+  }
+
+  void database::set_wal_handler(wal_handler h)
+  {
+    wh_ = h;
+    sqlite3_wal_hook(db_, wh_ ? wal_hook_impl : 0, &wh_);
+  }
+
   long long int database::last_insert_rowid() const
   {
     return sqlite3_last_insert_rowid(db_);
@@ -206,11 +460,140 @@ namespace sqlite3pp
     return sqlite3_extended_result_codes(db_, enable ? 1 : 0);
   }
 
+  int database::tune(options const& opts)
+  {
+    // page_size has to come before journal_mode, which can fix it.
+    auto rc = SQLITE_OK;
+    if (rc == SQLITE_OK && opts.page_size > 0)
+      rc = executef("PRAGMA page_size=%d", opts.page_size);
+    if (rc == SQLITE_OK && !opts.journal_mode.empty())
+      rc = executef("PRAGMA journal_mode=%Q", opts.journal_mode.c_str());
+    if (rc == SQLITE_OK && opts.mmap_size >= 0)
+      rc = executef("PRAGMA mmap_size=%lld", opts.mmap_size);
+    if (rc == SQLITE_OK && opts.cache_size != 0)
+      rc = executef("PRAGMA cache_size=%d", opts.cache_size);
+    if (rc == SQLITE_OK && opts.synchronous >= 0)
+      rc = executef("PRAGMA synchronous=%d", opts.synchronous);
+    if (rc == SQLITE_OK && opts.temp_store >= 0)
+      rc = executef("PRAGMA temp_store=%d", opts.temp_store);
+    if (rc == SQLITE_OK && opts.wal_autocheckpoint >= 0)
+      rc = executef("PRAGMA wal_autocheckpoint=%d", opts.wal_autocheckpoint);
+    return rc;
+  }
+
+  database::options database::tune() const
+  {
+    options opts;
+    opts.mmap_size = pragma_int("mmap_size");
+    opts.cache_size = static_cast<int>(pragma_int("cache_size"));
+    opts.page_size = static_cast<int>(pragma_int("page_size"));
+    opts.journal_mode = pragma_text("journal_mode");
+    opts.synchronous = static_cast<int>(pragma_int("synchronous"));
+    opts.temp_store = static_cast<int>(pragma_int("temp_store"));
+    opts.wal_autocheckpoint = static_cast<int>(pragma_int("wal_autocheckpoint"));
+    return opts;
+  }
+
+  long long int database::pragma_int(char const* name) const
+  {
+    auto sql = std::string("PRAGMA ") + name;
+    sqlite3_stmt* stmt = nullptr;
+    long long int value = -1;
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW)
+      value = sqlite3_column_int64(stmt, 0);
+    sqlite3_finalize(stmt);
+    return value;
+  }
+
+  std::string database::pragma_text(char const* name) const
+  {
+    auto sql = std::string("PRAGMA ") + name;
+    sqlite3_stmt* stmt = nullptr;
+    std::string value;
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+      auto p = reinterpret_cast<char const*>(sqlite3_column_text(stmt, 0));
+      value = p ? p : "";
+    }
+    sqlite3_finalize(stmt);
+    return value;
+  }
+
+#ifdef SQLITE3PP_HAS_SERIALIZE
+  int database::serialize(image& img, char const* schema, bool fnocopy) const
+  {
+    sqlite3_int64 n = -1;
+    unsigned char* p = nullptr;
+    bool fowned = true;
+    if (fnocopy) {
+      p = sqlite3_serialize(db_, schema, &n, SQLITE_SERIALIZE_NOCOPY);
+      fowned = !p;
+    }
+    if (!p) {
+      p = sqlite3_serialize(db_, schema, &n, 0);
+    }
+    if (!p && n != 0) {
+      return n < 0 ? SQLITE_ERROR : SQLITE_NOMEM;
+    }
+
+    img.clear();
+    img.data_ = p;
+    img.size_ = static_cast<std::size_t>(n);
+    img.fowned_ = fowned && p;
+    return SQLITE_OK;
+  }
+
+  int database::deserialize(image&& img, char const* schema, bool freadonly)
+  {
+    auto p = img.data_;
+    auto n = img.size_;
+    if (!img.fowned_ && n > 0) {
+      p = static_cast<unsigned char*>(sqlite3_malloc64(n));
+      if (!p) return SQLITE_NOMEM;
+      std::memcpy(p, img.data_, n);
+    }
+    img.data_ = nullptr;
+    img.size_ = 0;
+    img.fowned_ = false;
+
+    // The memory VFS can't keep a WAL, so an image of a WAL database is
+    // marked as a rollback journal one in bytes 18 and 19 of its header.
+    if (n >= 20 && p[18] == 2 && p[19] == 2) {
+      p[18] = p[19] = 1;
+    }
+
+    // SQLite frees the memory even if this fails.
+    auto flags = SQLITE_DESERIALIZE_FREEONCLOSE | (freadonly ? SQLITE_DESERIALIZE_READONLY : SQLITE_DESERIALIZE_RESIZEABLE);
+    return sqlite3_deserialize(db_, schema, p, n, n, flags);
+  }
+
+  int database::deserialize(void const* data, std::size_t n, char const* schema)
+  {
+    auto p = static_cast<unsigned char*>(const_cast<void*>(data));
+    return sqlite3_deserialize(db_, schema, p, n, n, SQLITE_DESERIALIZE_READONLY);
+  }
+#endif
+
   int database::changes() const
   {
     return sqlite3_changes(db_);
   }
 
+  char const* database::filename(char const* dbname) const
+  {
+    auto f = sqlite3_db_filename(db_, dbname);
+    return f ? f : "";
+  }
+
+  int database::checkpoint(char const* dbname, int mode, int* log, int* ckpt)
+  {
+    return sqlite3_wal_checkpoint_v2(db_, dbname, mode, log, ckpt);
+  }
+
+  void database::interrupt()
+  {
+    sqlite3_interrupt(db_);
+  }
+
   int database::error_code() const
   {
     return sqlite3_errcode(db_);
@@ -231,6 +614,21 @@ namespace sqlite3pp
     return sqlite3_exec(db_, sql, 0, 0, 0);
   }
 
+  int database::execute_xct(std::string const& sql)
+  {
+    auto& stmt = xcts_[sql];
+    if (!stmt) {
+      auto rc = sqlite3_prepare_v2(db_, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
+      if (rc != SQLITE_OK) {
+        xcts_.erase(sql);
+        return rc;
+      }
+    }
+    auto rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+  }
+
   int database::executef(char const* sql, ...)
   {
     va_list ap;
@@ -246,11 +644,21 @@ namespace sqlite3pp
     return sqlite3_busy_timeout(db_, ms);
   }
 
+  statement_cache& database::stmt_cache()
+  {
+    return sc_;
+  }
+
+  statement_cache const& database::stmt_cache() const
+  {
+    return sc_;
+  }
+
 
-  statement::statement(database& db, char const* stmt) : db_(db), stmt_(0), tail_(0)
+  statement::statement(database& db, char const* stmt, unsigned int prepflags, int nbytes) : db_(db), stmt_(0), tail_(0), sqlend_(0), prepflags_(0), cached_(false), pending_(0), holder_(0), fchained_(false), fexhausted_(false), serial_(0)
   {
     if (stmt) {
-      auto rc = prepare(stmt);
+      auto rc = prepare(stmt, prepflags, nbytes);
       if (rc != SQLITE_OK)
         throw database_error(db_);
     }
@@ -263,18 +671,163 @@ namespace sqlite3pp
     finish();
   }
 
-  int statement::prepare(char const* stmt)
+  int statement::prepare(char const* stmt, unsigned int prepflags, int nbytes)
   {
     auto rc = finish();
     if (rc != SQLITE_OK)
       return rc;
 
-    return prepare_impl(stmt);
+    static std::atomic<unsigned long long> serials(0);
+    serial_ = ++serials;
+    prepflags_ = prepflags;
+    sqlend_ = nbytes < 0 ? nullptr : stmt + nbytes;
+
+    if (db_.sc_.capacity() == 0)
+      return prepare_impl(stmt, nbytes, &stmt_, &tail_);
+
+    auto sql = nbytes < 0 ? std::string(stmt) : std::string(stmt, nbytes);
+    if (db_.sc_.acquire(sql, prepflags, centry_)) {
+      stmt_ = centry_->stmt;
+      tail_ = stmt + centry_->tail;
+      cached_ = true;
+      return SQLITE_OK;
+    }
+
+#if SQLITE_VERSION_NUMBER >= 3020000
+    // Cached statements live long, so keep them out of lookaside memory.
+    prepflags_ |= SQLITE_PREPARE_PERSISTENT;
+#endif
+    rc = prepare_impl(stmt, nbytes, &stmt_, &tail_);
+    if (rc == SQLITE_OK && stmt_) {
+      centry_ = db_.sc_.insert(sql, prepflags, stmt_, tail_ - stmt);
+      cached_ = true;
+    }
+    return rc;
+  }
+
+  int statement::prepare_impl(char const* stmt, int nbytes, sqlite3_stmt** ppstmt, char const** ptail)
+  {
+#if SQLITE_VERSION_NUMBER >= 3020000
+    return sqlite3_prepare_v3(db_.db_, stmt, nbytes, prepflags_, ppstmt, ptail);
+#else
+    return sqlite3_prepare_v2(db_.db_, stmt, nbytes, ppstmt, ptail);
+#endif
+  }
+
+  int statement::prepare_chain()
+  {
+    fchained_ = true;
+    pending_ = stmt_ ? tail_ : nullptr;
+    auto fschema = stmt_ && changes_schema(stmt_);
+
+    while (pending_ && remaining(pending_) > 0) { // sqlite3_complete() is broken.
+      sqlite3_stmt* stmt = nullptr;
+      char const* tail = nullptr;
+      // A statement can depend on the schema changes of the ones before it,
+      // e.g. CREATE TABLE followed by INSERT. If it can't be prepared yet,
+      // execute_all() tries again after running the ones before it. If none
+      // of those changes the schema, the error is final.
+      auto rc = prepare_impl(pending_, remaining(pending_), &stmt, &tail);
+      if (rc != SQLITE_OK) {
+        if (fschema)
+          return SQLITE_OK;
+
+        for (auto const& sub : subs_) {
+          sqlite3_finalize(sub.stmt);
+        }
+        subs_.clear();
+        subnames_.clear();
+        pending_ = nullptr;
+        fchained_ = false;
+        return rc;
+      }
+
+      pending_ = tail;
+      if (stmt) {
+        fschema = fschema || changes_schema(stmt);
+        subs_.push_back(substatement{stmt, map_params(stmt)});
+      }
+    }
+    pending_ = nullptr;
+
+    return SQLITE_OK;
+  }
+
+  int statement::remaining(char const* sql) const
+  {
+    return sqlend_ ? static_cast<int>(sqlend_ - sql) : static_cast<int>(std::strlen(sql));
+  }
+
+  std::vector<int> statement::map_params(sqlite3_stmt* stmt)
+  {
+    auto count = sqlite3_bind_parameter_count(stmt_);
+    auto subcount = sqlite3_bind_parameter_count(stmt);
+
+    // Named parameters that stmt_ doesn't have get indexes after its own.
+    for (int i = 1; i <= subcount; ++i) {
+      auto name = sqlite3_bind_parameter_name(stmt, i);
+      if (name && param_index(name) == 0) {
+        subnames_.push_back(name);
+      }
+    }
+
+    std::vector<int> params(count + subnames_.size() + 1, 0);
+    for (int i = 1; i <= count; ++i) {
+      auto name = sqlite3_bind_parameter_name(stmt_, i);
+      if (name) {
+        params[i] = sqlite3_bind_parameter_index(stmt, name);
+      }
+      else if (i <= subcount) {
+        params[i] = i;
+      }
+    }
+    for (std::size_t i = 0; i < subnames_.size(); ++i) {
+      params[count + i + 1] = sqlite3_bind_parameter_index(stmt, subnames_[i]);
+    }
+    return params;
+  }
+
+  int statement::param_index(char const* name)
+  {
+    if (!fchained_ && prepare_chain() != SQLITE_OK)
+      return 0;
+
+    auto idx = sqlite3_bind_parameter_index(stmt_, name);
+    if (idx > 0)
+      return idx;
+
+    for (std::size_t i = 0; i < subnames_.size(); ++i) {
+      if (std::strcmp(subnames_[i], name) == 0)
+        return sqlite3_bind_parameter_count(stmt_) + static_cast<int>(i) + 1;
+    }
+    return 0;
+  }
+
+  sqlite3_stmt* statement::value_holder()
+  {
+    if (!holder_)
+      sqlite3_prepare_v2(db_.db_, "SELECT ?", -1, &holder_, nullptr);
+    return holder_;
   }
 
-  int statement::prepare_impl(char const* stmt)
+  int statement::keep_value(int idx)
   {
-    return sqlite3_prepare(db_.db_, stmt, std::strlen(stmt), &stmt_, &tail_);
+    sqlite3_value* value = nullptr;
+    auto rc = sqlite3_step(holder_);
+    if (rc == SQLITE_ROW) {
+      value = sqlite3_value_dup(sqlite3_column_value(holder_, 0));
+      rc = value ? SQLITE_OK : SQLITE_NOMEM;
+    }
+    sqlite3_reset(holder_);
+    sqlite3_clear_bindings(holder_);
+    if (rc != SQLITE_OK)
+      return rc;
+
+    if (static_cast<int>(values_.size()) <= idx)
+      values_.resize(idx + 1, nullptr);
+    sqlite3_value_free(values_[idx]);
+    values_[idx] = value;
+    return SQLITE_OK;
   }
 
   int statement::finish()
@@ -284,13 +837,79 @@ namespace sqlite3pp
       rc = finish_impl(stmt_);
       stmt_ = nullptr;
     }
+    for (auto const& sub : subs_) {
+      sqlite3_finalize(sub.stmt);
+    }
+    subs_.clear();
+    subnames_.clear();
+    colnames_.clear();
+    sqlite3_finalize(holder_);
+    holder_ = nullptr;
+    for (auto value : values_) {
+      sqlite3_value_free(value);
+    }
+    values_.clear();
     tail_ = nullptr;
+    sqlend_ = nullptr;
+    pending_ = nullptr;
+    fchained_ = false;
+    fexhausted_ = false;
 
     return rc;
   }
 
+  int statement::bind_arg(int idx, int value)
+  {
+    return bind(idx, value);
+  }
+
+  int statement::bind_arg(int idx, double value)
+  {
+    return bind(idx, value);
+  }
+
+  int statement::bind_arg(int idx, long long int value)
+  {
+    return bind(idx, value);
+  }
+
+  int statement::bind_arg(int idx, char const* value)
+  {
+    return bind(idx, value, nocopy);
+  }
+
+  int statement::bind_arg(int idx, std::string const& value)
+  {
+    return bind_text(idx, value.data(), value.size(), nocopy);
+  }
+
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+  int statement::bind_arg(int idx, std::string_view value)
+  {
+    return bind_text(idx, value.data(), value.size(), nocopy);
+  }
+#endif
+
+  int statement::bind_arg(int idx, blob_view value)
+  {
+    return bind(idx, value, nocopy);
+  }
+
+  int statement::bind_arg(int idx, null_type)
+  {
+    return bind(idx);
+  }
+
   int statement::finish_impl(sqlite3_stmt* stmt)
   {
+    if (cached_ && centry_->stmt == stmt) {
+      // Hand the statement back to the cache instead of finalizing it.
+      cached_ = false;
+      auto rc = sqlite3_reset(stmt);
+      sqlite3_clear_bindings(stmt);
+      db_.sc_.release(centry_);
+      return rc;
+    }
     return sqlite3_finalize(stmt);
   }
 
@@ -301,42 +920,79 @@ namespace sqlite3pp
 
   int statement::reset()
   {
+    fexhausted_ = false;
     return sqlite3_reset(stmt_);
   }
 
+  int statement::stmt_status(int op, bool freset)
+  {
+    auto n = stmt_ ? sqlite3_stmt_status(stmt_, op, freset) : 0;
+    for (auto const& sub : subs_) {
+      n += sqlite3_stmt_status(sub.stmt, op, freset);
+    }
+    return n;
+  }
+
   int statement::bind(int idx, int value)
   {
-    return sqlite3_bind_int(stmt_, idx, value);
+    return bind_impl(idx, [&](sqlite3_stmt* s, int i) {
+      return sqlite3_bind_int(s, i, value);
+    });
   }
 
   int statement::bind(int idx, double value)
   {
-    return sqlite3_bind_double(stmt_, idx, value);
+    return bind_impl(idx, [&](sqlite3_stmt* s, int i) {
+      return sqlite3_bind_double(s, i, value);
+    });
   }
 
   int statement::bind(int idx, long long int value)
   {
-    return sqlite3_bind_int64(stmt_, idx, value);
+    return bind_impl(idx, [&](sqlite3_stmt* s, int i) {
+      return sqlite3_bind_int64(s, i, value);
+    });
   }
 
   int statement::bind(int idx, char const* value, copy_semantic fcopy)
   {
-    return sqlite3_bind_text(stmt_, idx, value, std::strlen(value), fcopy == copy ? SQLITE_TRANSIENT : SQLITE_STATIC );
+    auto n = std::strlen(value);
+    return bind_impl(idx, [&](sqlite3_stmt* s, int i) {
+      return sqlite3_bind_text(s, i, value, n, fcopy == copy ? SQLITE_TRANSIENT : SQLITE_STATIC );
+    });
   }
 
   int statement::bind(int idx, void const* value, int n, copy_semantic fcopy)
   {
-    return sqlite3_bind_blob(stmt_, idx, value, n, fcopy == copy ? SQLITE_TRANSIENT : SQLITE_STATIC );
+    return bind_impl(idx, [&](sqlite3_stmt* s, int i) {
+      return sqlite3_bind_blob(s, i, value, n, fcopy == copy ? SQLITE_TRANSIENT : SQLITE_STATIC );
+    });
   }
 
   int statement::bind(int idx, std::string const& value, copy_semantic fcopy)
   {
-    return sqlite3_bind_text(stmt_, idx, value.c_str(), value.size(), fcopy == copy ? SQLITE_TRANSIENT : SQLITE_STATIC );
+    return bind_impl(idx, [&](sqlite3_stmt* s, int i) {
+      return sqlite3_bind_text(s, i, value.c_str(), value.size(), fcopy == copy ? SQLITE_TRANSIENT : SQLITE_STATIC );
+    });
+  }
+
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+  int statement::bind(int idx, std::string_view value, copy_semantic fcopy)
+  {
+    return bind_text(idx, value.data(), value.size(), fcopy);
+  }
+#endif
+
+  int statement::bind(int idx, blob_view value, copy_semantic fcopy)
+  {
+    return bind(idx, value.data, value.size, fcopy);
   }
 
   int statement::bind(int idx)
   {
-    return sqlite3_bind_null(stmt_, idx);
+    return bind_impl(idx, [&](sqlite3_stmt* s, int i) {
+      return sqlite3_bind_null(s, i);
+    });
   }
 
   int statement::bind(int idx, null_type)
@@ -346,43 +1002,57 @@ namespace sqlite3pp
 
   int statement::bind(char const* name, int value)
   {
-    auto idx = sqlite3_bind_parameter_index(stmt_, name);
+    auto idx = param_index(name);
     return bind(idx, value);
   }
 
   int statement::bind(char const* name, double value)
   {
-    auto idx = sqlite3_bind_parameter_index(stmt_, name);
+    auto idx = param_index(name);
     return bind(idx, value);
   }
 
   int statement::bind(char const* name, long long int value)
   {
-    auto idx = sqlite3_bind_parameter_index(stmt_, name);
+    auto idx = param_index(name);
     return bind(idx, value);
   }
 
   int statement::bind(char const* name, char const* value, copy_semantic fcopy)
   {
-    auto idx = sqlite3_bind_parameter_index(stmt_, name);
+    auto idx = param_index(name);
     return bind(idx, value, fcopy);
   }
 
   int statement::bind(char const* name, void const* value, int n, copy_semantic fcopy)
   {
-    auto idx = sqlite3_bind_parameter_index(stmt_, name);
+    auto idx = param_index(name);
     return bind(idx, value, n, fcopy);
   }
 
   int statement::bind(char const* name, std::string const& value, copy_semantic fcopy)
   {
-    auto idx = sqlite3_bind_parameter_index(stmt_, name);
+    auto idx = param_index(name);
+    return bind(idx, value, fcopy);
+  }
+
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+  int statement::bind(char const* name, std::string_view value, copy_semantic fcopy)
+  {
+    auto idx = param_index(name);
+    return bind(idx, value, fcopy);
+  }
+#endif
+
+  int statement::bind(char const* name, blob_view value, copy_semantic fcopy)
+  {
+    auto idx = param_index(name);
     return bind(idx, value, fcopy);
   }
 
   int statement::bind(char const* name)
   {
-    auto idx = sqlite3_bind_parameter_index(stmt_, name);
+    auto idx = param_index(name);
     return bind(idx);
   }
 
@@ -391,16 +1061,42 @@ namespace sqlite3pp
     return bind(name);
   }
 
-
-  command::bindstream::bindstream(command& cmd, int idx) : cmd_(cmd), idx_(idx)
+  int statement::bind_text(int idx, char const* value, std::size_t n, copy_semantic fcopy)
   {
+    return bind_impl(idx, [&](sqlite3_stmt* s, int i) {
+      return sqlite3_bind_text64(s, i, value, n, fcopy == copy ? SQLITE_TRANSIENT : SQLITE_STATIC, SQLITE_UTF8);
+    });
   }
 
-  command::command(database& db, char const* stmt) : statement(db, stmt)
+  int statement::bind_text(char const* name, char const* value, std::size_t n, copy_semantic fcopy)
   {
+    auto idx = param_index(name);
+    return bind_text(idx, value, n, fcopy);
   }
 
-  command::bindstream command::binder(int idx)
+  int statement::bind_zeroblob(int idx, long long int n)
+  {
+    return bind_impl(idx, [&](sqlite3_stmt* s, int i) {
+      return sqlite3_bind_zeroblob64(s, i, n);
+    });
+  }
+
+  int statement::bind_zeroblob(char const* name, long long int n)
+  {
+    auto idx = param_index(name);
+    return bind_zeroblob(idx, n);
+  }
+
+
+  command::bindstream::bindstream(command& cmd, int idx) : cmd_(cmd), idx_(idx), fcopy_(copy)
+  {
+  }
+
+  command::command(database& db, char const* stmt, unsigned int prepflags, int nbytes) : statement(db, stmt, prepflags, nbytes)
+  {
+  }
+
+  command::bindstream command::binder(int idx)
   {
     return bindstream(*this, idx);
   }
@@ -415,34 +1111,128 @@ namespace sqlite3pp
 
   int command::execute_all()
   {
-    auto rc = execute();
+    auto rc = fchained_ ? SQLITE_OK : prepare_chain();
     if (rc != SQLITE_OK) return rc;
 
-    char const* sql = tail_;
+    rc = execute();
+    if (rc != SQLITE_OK) return rc;
+
+    for (auto const& sub : subs_) {
+      rc = sqlite3_step(sub.stmt);
+      sqlite3_reset(sub.stmt);
+      if (rc == SQLITE_DONE) rc = SQLITE_OK;
+      if (rc != SQLITE_OK) return rc;
+    }
 
-    while (std::strlen(sql) > 0) { // sqlite3_complete() is broken.
-      sqlite3_stmt* old_stmt = stmt_;
+    // The statements that couldn't be prepared up front are prepared now
+    // and kept for the next call, with the values bound so far.
+    while (pending_ && remaining(pending_) > 0) { // sqlite3_complete() is broken.
+      sqlite3_stmt* stmt = nullptr;
+      char const* tail = nullptr;
 
-      if ((rc = prepare_impl(sql)) != SQLITE_OK) return rc;
+      if ((rc = prepare_impl(pending_, remaining(pending_), &stmt, &tail)) != SQLITE_OK) return rc;
 
-      if ((rc = sqlite3_transfer_bindings(old_stmt, stmt_)) != SQLITE_OK) return rc;
+      pending_ = tail;
+      if (!stmt) continue;
 
-      finish_impl(old_stmt);
+      subs_.push_back(substatement{stmt, map_params(stmt)});
 
-      if ((rc = execute()) != SQLITE_OK) return rc;
+      auto const& params = subs_.back().params;
+      for (std::size_t i = 1; i < params.size() && i < values_.size(); ++i) {
+        if (params[i] > 0 && values_[i]) {
+          if ((rc = sqlite3_bind_value(stmt, params[i], values_[i])) != SQLITE_OK) return rc;
+        }
+      }
 
-      sql = tail_;
+      rc = sqlite3_step(stmt);
+      sqlite3_reset(stmt);
+
+      if (rc == SQLITE_DONE) rc = SQLITE_OK;
+      if (rc != SQLITE_OK) return rc;
     }
+    pending_ = nullptr;
 
     return rc;
   }
 
 
+  arena::arena(std::size_t block_size) : block_size_(block_size ? block_size : 1), cur_(0), off_(0), used_(0)
+  {
+  }
+
+  arena::arena(arena&& a) : blocks_(std::move(a.blocks_)), block_size_(a.block_size_), cur_(a.cur_), off_(a.off_), used_(a.used_)
+  {
+    a.blocks_.clear();
+    a.cur_ = a.off_ = a.used_ = 0;
+  }
+
+  arena& arena::operator=(arena&& a)
+  {
+    blocks_ = std::move(a.blocks_);
+    block_size_ = a.block_size_;
+    cur_ = a.cur_;
+    off_ = a.off_;
+    used_ = a.used_;
+
+    a.blocks_.clear();
+    a.cur_ = a.off_ = a.used_ = 0;
+
+    return *this;
+  }
+
+  void* arena::allocate(std::size_t n, std::size_t align)
+  {
+    for (; cur_ < blocks_.size(); ++cur_, off_ = 0) {
+      auto& b = blocks_[cur_];
+      auto addr = reinterpret_cast<std::uintptr_t>(b.data.get()) + off_;
+      auto pad = (align - addr % align) % align;
+      if (off_ + pad + n <= b.size) {
+        auto p = b.data.get() + off_ + pad;
+        off_ += pad + n;
+        used_ += n;
+        return p;
+      }
+    }
+
+    auto size = std::max(block_size_, n + align);
+    blocks_.push_back(block{std::unique_ptr<char[]>(new char[size]), size});
+    cur_ = blocks_.size() - 1;
+    off_ = 0;
+    return allocate(n, align);
+  }
+
+  char const* arena::copy(void const* data, std::size_t n)
+  {
+    auto p = static_cast<char*>(allocate(n + 1, 1));
+    std::memcpy(p, data, n);
+    p[n] = '\0';
+    return p;
+  }
+
+  void arena::reset()
+  {
+    cur_ = off_ = used_ = 0;
+  }
+
+  std::size_t arena::used() const
+  {
+    return used_;
+  }
+
+  std::size_t arena::capacity() const
+  {
+    std::size_t size = 0;
+    for (auto const& b : blocks_) {
+      size += b.size;
+    }
+    return size;
+  }
+
   query::rows::getstream::getstream(rows* rws, int idx) : rws_(rws), idx_(idx)
   {
   }
 
-  query::rows::rows(sqlite3_stmt* stmt) : stmt_(stmt)
+  query::rows::rows(sqlite3_stmt* stmt, query const* cmd) : stmt_(stmt), cmd_(cmd)
   {
   }
 
@@ -461,6 +1251,24 @@ namespace sqlite3pp
     return sqlite3_column_bytes(stmt_, idx);
   }
 
+  int query::rows::column_index(char const* name) const
+  {
+    auto idx = -1;
+    if (cmd_) {
+      idx = cmd_->column_index(name);
+    }
+    else {
+      auto n = sqlite3_column_count(stmt_);
+      for (int i = 0; i < n && idx < 0; ++i) {
+        if (std::strcmp(sqlite3_column_name(stmt_, i), name) == 0)
+          idx = i;
+      }
+    }
+    if (idx < 0)
+      throw database_error((std::string("no such column: ") + name).c_str());
+    return idx;
+  }
+
   int query::rows::get(int idx, int) const
   {
     return sqlite3_column_int(stmt_, idx);
@@ -478,17 +1286,38 @@ namespace sqlite3pp
 
   char const* query::rows::get(int idx, char const*) const
   {
-    return reinterpret_cast<char const*>(sqlite3_column_text(stmt_, idx));
+    auto p = reinterpret_cast<char const*>(sqlite3_column_text(stmt_, idx));
+    if (p && cmd_ && cmd_->arena_)
+      return cmd_->arena_->copy(p, column_bytes(idx));
+    return p;
   }
 
   std::string query::rows::get(int idx, std::string) const
   {
-    return get(idx, (char const*)0);
+    auto p = reinterpret_cast<char const*>(sqlite3_column_text(stmt_, idx));
+    return p ? std::string(p, column_bytes(idx)) : std::string();
   }
 
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+  std::string_view query::rows::get(int idx, std::string_view) const
+  {
+    auto p = get(idx, (char const*)0);
+    return p ? std::string_view(p, column_bytes(idx)) : std::string_view();
+  }
+#endif
+
   void const* query::rows::get(int idx, void const*) const
   {
-    return sqlite3_column_blob(stmt_, idx);
+    return get(idx, blob_view()).data;
+  }
+
+  blob_view query::rows::get(int idx, blob_view) const
+  {
+    auto p = sqlite3_column_blob(stmt_, idx);
+    auto n = column_bytes(idx);
+    if (p && cmd_ && cmd_->arena_)
+      p = cmd_->arena_->copy(p, n);
+    return blob_view{p, n};
   }
 
   null_type query::rows::get(int /*idx*/, null_type) const
@@ -532,10 +1361,10 @@ namespace sqlite3pp
 
   query::query_iterator::value_type query::query_iterator::operator*() const
   {
-    return rows(cmd_->stmt_);
+    return rows(cmd_->stmt_, cmd_);
   }
 
-  query::query(database& db, char const* stmt) : statement(db, stmt)
+  query::query(database& db, char const* stmt, unsigned int prepflags, int nbytes) : statement(db, stmt, prepflags, nbytes), arena_(nullptr)
   {
   }
 
@@ -554,6 +1383,40 @@ namespace sqlite3pp
     return sqlite3_column_decltype(stmt_, idx);
   }
 
+  int query::column_index(char const* name) const
+  {
+    using colname = std::pair<std::string, int>;
+
+    if (colnames_.empty()) {
+      auto n = column_count();
+      colnames_.reserve(n);
+      for (int i = 0; i < n; ++i) {
+        colnames_.emplace_back(column_name(i), i);
+      }
+      // Stable, so that the leftmost of duplicate names wins.
+      std::stable_sort(colnames_.begin(), colnames_.end(), [](colname const& a, colname const& b) {
+        return a.first < b.first;
+      });
+    }
+
+    auto it = std::lower_bound(colnames_.begin(), colnames_.end(), name, [](colname const& a, char const* b) {
+      return std::strcmp(a.first.c_str(), b) < 0;
+    });
+    if (it != colnames_.end() && it->first == name)
+      return it->second;
+    return -1;
+  }
+
+  void query::set_arena(arena* a)
+  {
+    arena_ = a;
+  }
+
+  arena* query::get_arena() const
+  {
+    return arena_;
+  }
+
 
   query::iterator query::begin()
   {
@@ -565,10 +1428,139 @@ namespace sqlite3pp
     return query_iterator();
   }
 
+  std::size_t query::fetch_batch(column_batch& batch, std::size_t n)
+  {
+    int ncol = column_count();
+    if (batch.source_ != serial_ || batch.column_count() != ncol) {
+      batch.columns_.assign(ncol, column_batch::column());
+      batch.source_ = serial_;
+    }
+    batch.clear();
+
+    // Stepping again after SQLITE_DONE would start the query over.
+    if (fexhausted_)
+      return 0;
+
+    std::size_t row = 0;
+    for (; row < n; ++row) {
+      auto rc = step();
+      if (rc == SQLITE_DONE) {
+        fexhausted_ = true;
+        break;
+      }
+      if (rc != SQLITE_ROW)
+        throw database_error(db_);
+
+      for (int i = 0; i < ncol; ++i) {
+        auto& c = batch.columns_[i];
+        if (!c.type)
+          c.type = column_kind(i);
+
+        auto fnull = sqlite3_column_type(stmt_, i) == SQLITE_NULL;
+        if (row % 8 == 0)
+          c.valid.push_back(0);
+        if (!fnull)
+          c.valid.back() |= static_cast<unsigned char>(1 << (row % 8));
+
+        switch (c.type) {
+          case SQLITE_INTEGER:
+            c.ints.push_back(fnull ? 0 : sqlite3_column_int64(stmt_, i));
+            break;
+          case SQLITE_FLOAT:
+            c.reals.push_back(fnull ? 0.0 : sqlite3_column_double(stmt_, i));
+            break;
+          default:
+            if (!fnull) {
+              auto p = static_cast<char const*>(c.type == SQLITE_BLOB ? sqlite3_column_blob(stmt_, i) : sqlite3_column_text(stmt_, i));
+              c.bytes.insert(c.bytes.end(), p, p + sqlite3_column_bytes(stmt_, i));
+            }
+            c.offsets.push_back(c.bytes.size());
+            break;
+        }
+      }
+    }
+    batch.rows_ = row;
+    return row;
+  }
+
+  int query::column_kind(int idx) const
+  {
+    if (auto decl = column_decltype(idx)) {
+      std::string t(decl);
+      std::transform(t.begin(), t.end(), t.begin(), [](char ch) { return static_cast<char>(std::toupper(static_cast<unsigned char>(ch))); });
+      // SQLite's column affinity rules, in their order.
+      if (t.find("INT") != std::string::npos)
+        return SQLITE_INTEGER;
+      if (t.find("CHAR") != std::string::npos || t.find("CLOB") != std::string::npos || t.find("TEXT") != std::string::npos)
+        return SQLITE_TEXT;
+      if (t.find("BLOB") != std::string::npos)
+        return SQLITE_BLOB;
+      if (t.find("REAL") != std::string::npos || t.find("FLOA") != std::string::npos || t.find("DOUB") != std::string::npos)
+        return SQLITE_FLOAT;
+    }
+    auto type = sqlite3_column_type(stmt_, idx);
+    return type == SQLITE_NULL ? SQLITE_TEXT : type;
+  }
+
+
+  column_batch::column_batch() : rows_(0), source_(0)
+  {
+  }
+
+  std::size_t column_batch::size() const
+  {
+    return rows_;
+  }
+
+  int column_batch::column_count() const
+  {
+    return static_cast<int>(columns_.size());
+  }
+
+  column_batch::column const& column_batch::operator[](int idx) const
+  {
+    return columns_[idx];
+  }
+
+  void column_batch::clear()
+  {
+    for (auto& c : columns_) {
+      c.ints.clear();
+      c.reals.clear();
+      c.offsets.assign(1, 0);
+      c.bytes.clear();
+      c.valid.clear();
+    }
+    rows_ = 0;
+  }
+
+  bool column_batch::column::is_null(std::size_t row) const
+  {
+    return !(valid[row / 8] & (1 << (row % 8)));
+  }
+
+  char const* column_batch::column::data(std::size_t row) const
+  {
+    return bytes.data() + offsets[row];
+  }
+
+  std::size_t column_batch::column::length(std::size_t row) const
+  {
+    return offsets[row + 1] - offsets[row];
+  }
+
 
   transaction::transaction(database& db, bool fcommit, bool freserve) : db_(&db), fcommit_(fcommit)
   {
-    int rc = db_->execute(freserve ? "BEGIN IMMEDIATE" : "BEGIN");
+    int rc = db_->execute_xct(freserve ? "BEGIN IMMEDIATE" : "BEGIN");
+    if (rc != SQLITE_OK)
+      throw database_error(*db_);
+  }
+
+  transaction::transaction(database& db, transaction_mode mode, bool fcommit) : db_(&db), fcommit_(fcommit)
+  {
+    int rc = db_->execute_xct(mode == transaction_mode::exclusive ? "BEGIN EXCLUSIVE" :
+                              mode == transaction_mode::immediate ? "BEGIN IMMEDIATE" : "BEGIN");
     if (rc != SQLITE_OK)
       throw database_error(*db_);
   }
@@ -579,7 +1571,7 @@ namespace sqlite3pp
       // execute() can return error. If you want to check the error,
       // call commit() or rollback() explicitly before this object is
       // destructed.
-      db_->execute(fcommit_ ? "COMMIT" : "ROLLBACK");
+      db_->execute_xct(fcommit_ ? "COMMIT" : "ROLLBACK");
     }
   }
 
@@ -587,7 +1579,7 @@ namespace sqlite3pp
   {
     auto db = db_;
     db_ = nullptr;
-    int rc = db->execute("COMMIT");
+    int rc = db->execute_xct("COMMIT");
     return rc;
   }
 
@@ -595,11 +1587,612 @@ namespace sqlite3pp
   {
     auto db = db_;
     db_ = nullptr;
-    int rc = db->execute("ROLLBACK");
+    int rc = db->execute_xct("ROLLBACK");
+    return rc;
+  }
+
+  savepoint::savepoint(database& db, bool frelease) : db_(&db), frelease_(frelease),
+    name_("sqlite3pp_sp" + std::to_string(db.spdepth_))
+  {
+    int rc = db_->execute_xct("SAVEPOINT " + name_);
+    if (rc != SQLITE_OK)
+      throw database_error(*db_);
+    ++db_->spdepth_;
+  }
+
+  savepoint::~savepoint()
+  {
+    if (db_) {
+      // release() and rollback() can return error. If you want to check the
+      // error, call one of them explicitly before this object is destructed.
+      if (frelease_)
+        release();
+      else
+        rollback();
+    }
+  }
+
+  int savepoint::release()
+  {
+    // A savepoint that fails to go stays open, and so does this object,
+    // which keeps its name taken.
+    int rc = db_->execute_xct("RELEASE " + name_);
+    if (rc == SQLITE_OK) {
+      --db_->spdepth_;
+      db_ = nullptr;
+    }
+    return rc;
+  }
+
+  int savepoint::rollback()
+  {
+    int rc = db_->execute_xct("ROLLBACK TO " + name_);
+    if (rc == SQLITE_OK)
+      rc = db_->execute_xct("RELEASE " + name_);
+    if (rc == SQLITE_OK) {
+      --db_->spdepth_;
+      db_ = nullptr;
+    }
     return rc;
   }
 
 
+  backup_job::backup_job(database& db, database& destdb, database::backup_handler h, backup_options const& opts) : backup_job("main", db, destdb, "main", h, opts)
+  {
+  }
+
+  backup_job::backup_job(char const* dbname, database& db, database& destdb, char const* destdbname, database::backup_handler h, backup_options const& opts) : backup_job(sqlite3_backup_init(destdb.db_, destdbname, db.db_, dbname), h, opts)
+  {
+    if (!bkup_)
+      throw database_error(destdb);
+  }
+
+  backup_job::backup_job(sqlite3_backup* bkup, database::backup_handler h, backup_options const& opts) :
+    bkup_(bkup), h_(h), opts_(opts), npage_(opts.step_page), rc_(SQLITE_OK), ncopied_(0),
+    delay_(0), backoff_(0), start_(std::chrono::steady_clock::now()), cancel_(false)
+  {
+  }
+
+  backup_job::~backup_job()
+  {
+    // finish() can return error. If you want to check the error, call
+    // finish() explicitly before this object is destructed.
+    finish();
+  }
+
+  int backup_job::step()
+  {
+    if (!bkup_)
+      return rc_;
+
+    if (cancel_) {
+      finish();
+      return rc_ = SQLITE_INTERRUPT;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    auto rc = sqlite3_backup_step(bkup_, npage_);
+    auto elapsed = std::chrono::steady_clock::now() - t0;
+
+    if (h_) {
+      h_(sqlite3_backup_remaining(bkup_), sqlite3_backup_pagecount(bkup_), rc);
+    }
+
+    if (rc == SQLITE_OK) {
+      ncopied_ += npage_;
+      backoff_ = delay_ = std::chrono::milliseconds(0);
+
+      if (opts_.step_time.count() > 0) {
+        if (elapsed < opts_.step_time / 2)
+          npage_ = std::min(npage_ * 2, opts_.max_step_page);
+        else if (elapsed > opts_.step_time)
+          npage_ = std::max(npage_ / 2, opts_.min_step_page);
+      }
+
+      if (opts_.max_pages_per_sec > 0) {
+        auto due = std::chrono::milliseconds(ncopied_ * 1000 / opts_.max_pages_per_sec);
+        auto spent = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_);
+        if (due > spent)
+          delay_ = due - spent;
+      }
+    }
+    else if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+      backoff_ = backoff_.count() == 0 ? opts_.backoff : std::min(backoff_ * 2, opts_.max_backoff);
+      delay_ = backoff_;
+    }
+    else {
+      finish();
+    }
+    return rc_ = rc;
+  }
+
+  int backup_job::run()
+  {
+    for (;;) {
+      auto rc = step();
+      if (done())
+        return rc;
+
+      // Sleeps in slices so that cancel() doesn't wait for a long backoff.
+      for (auto left = delay_; left.count() > 0 && !cancel_; left -= std::chrono::milliseconds(50)) {
+        sqlite3_sleep(static_cast<int>(std::min(left, std::chrono::milliseconds(50)).count()));
+      }
+    }
+  }
+
+  void backup_job::cancel()
+  {
+    cancel_ = true;
+  }
+
+  int backup_job::finish()
+  {
+    auto rc = SQLITE_OK;
+    if (bkup_) {
+      rc = sqlite3_backup_finish(bkup_);
+      bkup_ = nullptr;
+    }
+    return rc;
+  }
+
+  bool backup_job::done() const
+  {
+    return !bkup_;
+  }
+
+  int backup_job::remaining() const
+  {
+    return bkup_ ? sqlite3_backup_remaining(bkup_) : 0;
+  }
+
+  int backup_job::pagecount() const
+  {
+    return bkup_ ? sqlite3_backup_pagecount(bkup_) : 0;
+  }
+
+  int backup_job::step_page() const
+  {
+    return npage_;
+  }
+
+  std::chrono::milliseconds backup_job::delay() const
+  {
+    return delay_;
+  }
+
+
+  blob::blob(database& db, char const* table, char const* column, long long int rowid, bool fwrite, char const* dbname) : db_(&db), blob_(nullptr)
+  {
+    auto rc = sqlite3_blob_open(db_->db_, dbname, table, column, rowid, fwrite ? 1 : 0, &blob_);
+    if (rc != SQLITE_OK) {
+      sqlite3_blob_close(blob_);
+      blob_ = nullptr;
+      throw database_error(*db_);
+    }
+  }
+
+  blob::blob(blob&& b) : db_(b.db_), blob_(b.blob_)
+  {
+    b.blob_ = nullptr;
+  }
+
+  blob& blob::operator=(blob&& b)
+  {
+    close();
+
+    db_ = b.db_;
+    blob_ = b.blob_;
+    b.blob_ = nullptr;
+
+    return *this;
+  }
+
+  blob::~blob()
+  {
+    // close() can return error. If you want to check the error, call
+    // close() explicitly before this object is destructed.
+    close();
+  }
+
+  int blob::close()
+  {
+    auto rc = SQLITE_OK;
+    if (blob_) {
+      rc = sqlite3_blob_close(blob_);
+      blob_ = nullptr;
+    }
+    return rc;
+  }
+
+  int blob::reopen(long long int rowid)
+  {
+    return sqlite3_blob_reopen(blob_, rowid);
+  }
+
+  int blob::size() const
+  {
+    return sqlite3_blob_bytes(blob_);
+  }
+
+  int blob::read(void* data, int n, int offset)
+  {
+    return sqlite3_blob_read(blob_, data, n, offset);
+  }
+
+  int blob::write(void const* data, int n, int offset)
+  {
+    return sqlite3_blob_write(blob_, data, n, offset);
+  }
+
+
+  blobbuf::blobbuf(blob& b, std::size_t bufsize) : blob_(b), buf_(bufsize), off_(0)
+  {
+  }
+
+  blobbuf::~blobbuf()
+  {
+    sync();
+  }
+
+  blobbuf::int_type blobbuf::underflow()
+  {
+    if (gptr() && gptr() < egptr())
+      return traits_type::to_int_type(*gptr());
+
+    if (sync() != 0)
+      return traits_type::eof();
+
+    auto n = std::min(static_cast<int>(buf_.size()), blob_.size() - off_);
+    if (n <= 0 || blob_.read(buf_.data(), n, off_) != SQLITE_OK)
+      return traits_type::eof();
+
+    setg(buf_.data(), buf_.data(), buf_.data() + n);
+    return traits_type::to_int_type(*gptr());
+  }
+
+  blobbuf::int_type blobbuf::overflow(int_type c)
+  {
+    if (sync() != 0)
+      return traits_type::eof();
+
+    auto n = std::min(static_cast<int>(buf_.size()), blob_.size() - off_);
+    if (n <= 0)
+      return traits_type::eof();
+
+    setp(buf_.data(), buf_.data() + n);
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  int blobbuf::sync()
+  {
+    // Moves off_ to the current position and empties both areas.
+    if (pbase() && pptr() > pbase()) {
+      auto n = static_cast<int>(pptr() - pbase());
+      if (blob_.write(pbase(), n, off_) != SQLITE_OK)
+        return -1;
+      off_ += n;
+    }
+    else if (gptr()) {
+      off_ += static_cast<int>(gptr() - eback());
+    }
+    setp(nullptr, nullptr);
+    setg(nullptr, nullptr, nullptr);
+    return 0;
+  }
+
+  blobbuf::pos_type blobbuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode /*which*/)
+  {
+    if (sync() != 0)
+      return pos_type(off_type(-1));
+
+    off_type pos = dir == std::ios_base::beg ? off : dir == std::ios_base::cur ? off_ + off : blob_.size() + off;
+    if (pos < 0 || pos > blob_.size())
+      return pos_type(off_type(-1));
+
+    off_ = static_cast<int>(pos);
+    return pos_type(pos);
+  }
+
+  blobbuf::pos_type blobbuf::seekpos(pos_type pos, std::ios_base::openmode which)
+  {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+  }
+
+
+  image::image() : data_(nullptr), size_(0), fowned_(false)
+  {
+  }
+
+  image::image(void const* data, std::size_t n) : data_(nullptr), size_(n), fowned_(true)
+  {
+    if (n > 0) {
+      data_ = static_cast<unsigned char*>(sqlite3_malloc64(n));
+      if (!data_) throw std::bad_alloc();
+      std::memcpy(data_, data, n);
+    }
+  }
+
+  image::image(image&& img) : data_(img.data_), size_(img.size_), fowned_(img.fowned_)
+  {
+    img.data_ = nullptr;
+    img.size_ = 0;
+    img.fowned_ = false;
+  }
+
+  image& image::operator=(image&& img)
+  {
+    if (this != &img) {
+      clear();
+      data_ = img.data_;
+      size_ = img.size_;
+      fowned_ = img.fowned_;
+      img.data_ = nullptr;
+      img.size_ = 0;
+      img.fowned_ = false;
+    }
+    return *this;
+  }
+
+  image::~image()
+  {
+    clear();
+  }
+
+  int image::load(char const* path)
+  {
+    auto f = std::fopen(path, "rb");
+    if (!f) return SQLITE_CANTOPEN;
+
+    auto rc = SQLITE_IOERR;
+    if (std::fseek(f, 0, SEEK_END) == 0) {
+      auto n = std::ftell(f);
+      if (n >= 0 && std::fseek(f, 0, SEEK_SET) == 0) {
+        auto p = static_cast<unsigned char*>(n > 0 ? sqlite3_malloc64(n) : nullptr);
+        if (n > 0 && !p) {
+          rc = SQLITE_NOMEM;
+        }
+        else if (std::fread(p, 1, n, f) == static_cast<std::size_t>(n)) {
+          clear();
+          data_ = p;
+          size_ = n;
+          fowned_ = p != nullptr;
+          rc = SQLITE_OK;
+        }
+        else {
+          sqlite3_free(p);
+        }
+      }
+    }
+    std::fclose(f);
+    return rc;
+  }
+
+  unsigned char const* image::data() const
+  {
+    return data_;
+  }
+
+  std::size_t image::size() const
+  {
+    return size_;
+  }
+
+  bool image::owned() const
+  {
+    return fowned_;
+  }
+
+  void image::clear()
+  {
+    if (fowned_) {
+      sqlite3_free(data_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    fowned_ = false;
+  }
+
+#ifdef SQLITE3PP_HAS_MMAP
+  mapped_file::mapped_file(char const* path) : data_(nullptr), size_(0)
+  {
+    auto fd = ::open(path, O_RDONLY);
+    if (fd < 0) throw database_error("can't open file");
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw database_error("can't stat file");
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ > 0) {
+      auto p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+      if (p == MAP_FAILED) {
+        ::close(fd);
+        throw database_error("can't map file");
+      }
+      data_ = p;
+    }
+    ::close(fd);
+  }
+
+  mapped_file::mapped_file(mapped_file&& mf) : data_(mf.data_), size_(mf.size_)
+  {
+    mf.data_ = nullptr;
+    mf.size_ = 0;
+  }
+
+  mapped_file& mapped_file::operator=(mapped_file&& mf)
+  {
+    if (this != &mf) {
+      unmap();
+      data_ = mf.data_;
+      size_ = mf.size_;
+      mf.data_ = nullptr;
+      mf.size_ = 0;
+    }
+    return *this;
+  }
+
+  mapped_file::~mapped_file()
+  {
+    unmap();
+  }
+
+  void const* mapped_file::data() const
+  {
+    return data_;
+  }
+
+  std::size_t mapped_file::size() const
+  {
+    return size_;
+  }
+
+  void mapped_file::unmap()
+  {
+    if (data_) {
+      ::munmap(data_, size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+  }
+#endif
+
+  bulk_inserter::bulk_inserter(command& cmd, std::size_t batch_rows, std::size_t batch_bytes, bool ffast)
+    : cmd_(cmd), batch_rows_(batch_rows), batch_bytes_(batch_bytes), batch_count_(0), batch_size_(0),
+      rows_(0), bytes_(0), ffast_(false), synchronous_(0), start_(std::chrono::steady_clock::now())
+  {
+    // Neither pragma can be changed inside a transaction.
+    if (ffast && sqlite3_get_autocommit(sqlite3_db_handle(cmd_.stmt_))) {
+      {
+        query qry(cmd_.db_, "PRAGMA synchronous");
+        synchronous_ = (*qry.begin()).get<int>(0);
+      }
+      {
+        query qry(cmd_.db_, "PRAGMA journal_mode");
+        journal_mode_ = (*qry.begin()).get<std::string>(0);
+      }
+      if (cmd_.db_.execute("PRAGMA synchronous=OFF") != SQLITE_OK)
+        throw database_error(cmd_.db_);
+      // Leaving WAL mode would cost more than it saves.
+      if (journal_mode_ != "wal" && cmd_.db_.execute("PRAGMA journal_mode=MEMORY") != SQLITE_OK) {
+        database_error e(cmd_.db_);
+        cmd_.db_.executef("PRAGMA synchronous=%d", synchronous_);
+        throw e;
+      }
+      ffast_ = true;
+    }
+  }
+
+  bulk_inserter::~bulk_inserter()
+  {
+    // The transaction rolls back the rows that finish() didn't commit,
+    // like the ones of a batch cut short by an exception.
+    xct_.reset();
+    restore();
+  }
+
+  int bulk_inserter::commit()
+  {
+    batch_count_ = 0;
+    batch_size_ = 0;
+    if (!xct_)
+      return SQLITE_OK;
+
+    auto rc = xct_->commit();
+    xct_.reset();
+    return rc;
+  }
+
+  int bulk_inserter::finish()
+  {
+    auto rc = commit();
+    restore();
+    return rc;
+  }
+
+  unsigned long long bulk_inserter::rows() const
+  {
+    return rows_;
+  }
+
+  unsigned long long bulk_inserter::bytes() const
+  {
+    return bytes_;
+  }
+
+  double bulk_inserter::elapsed() const
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+  }
+
+  double bulk_inserter::rows_per_sec() const
+  {
+    auto secs = elapsed();
+    return secs > 0 ? rows_ / secs : 0;
+  }
+
+  void bulk_inserter::begin()
+  {
+    // The rows go into the caller's transaction if there is one.
+    if (!sqlite3_get_autocommit(sqlite3_db_handle(cmd_.stmt_)))
+      return;
+
+    xct_.reset(new transaction(cmd_.db_));
+  }
+
+  void bulk_inserter::restore()
+  {
+    if (!ffast_)
+      return;
+
+    ffast_ = false;
+    cmd_.db_.executef("PRAGMA synchronous=%d", synchronous_);
+    if (journal_mode_ != "wal")
+      cmd_.db_.executef("PRAGMA journal_mode=%s", journal_mode_.c_str());
+  }
+
+  std::size_t bulk_inserter::value_size(char const* value)
+  {
+    return std::strlen(value);
+  }
+
+  std::size_t bulk_inserter::value_size(std::string const& value)
+  {
+    return value.size();
+  }
+
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+  std::size_t bulk_inserter::value_size(std::string_view value)
+  {
+    return value.size();
+  }
+#endif
+
+  std::size_t bulk_inserter::value_size(blob_view value)
+  {
+    return value.size;
+  }
+
+  std::size_t bulk_inserter::value_size(null_type)
+  {
+    return 0;
+  }
+
+  void bulk_inserter::discard_row()
+  {
+    cmd_.reset();
+    sqlite3_clear_bindings(cmd_.stmt_);
+    for (auto const& sub : cmd_.subs_) {
+      sqlite3_clear_bindings(sub.stmt);
+    }
+  }
+
+
   database_error::database_error(char const* msg) : std::runtime_error(msg)
   {
   }
@@ -608,4 +2201,116 @@ namespace sqlite3pp
   {
   }
 
+  profiler::profiler(database& db, bool fenable) : db_(db), fenabled_(false)
+  {
+    if (fenable) {
+      enable();
+    }
+  }
+
+  profiler::~profiler()
+  {
+    disable();
+  }
+
+  void profiler::enable()
+  {
+    if (fenabled_) return;
+    db_.set_trace_handler(SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE, [this](unsigned int type, void* p, void* x) {
+      return trace(type, static_cast<sqlite3_stmt*>(p), x);
+    });
+    fenabled_ = true;
+  }
+
+  void profiler::disable()
+  {
+    if (!fenabled_) return;
+    db_.set_trace_handler(0, database::trace_handler());
+    fenabled_ = false;
+  }
+
+  bool profiler::enabled() const
+  {
+    return fenabled_;
+  }
+
+  std::vector<profiler::entry> profiler::snapshot() const
+  {
+    std::vector<entry> v;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      v.reserve(entries_.size());
+      for (auto const& e : entries_) {
+        v.push_back(e.second);
+      }
+    }
+    std::sort(v.begin(), v.end(), [](entry const& a, entry const& b) {
+      return a.total_ns > b.total_ns;
+    });
+    return v;
+  }
+
+  void profiler::reset()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    stmts_.clear();
+  }
+
+  int profiler::trace(unsigned int type, sqlite3_stmt* stmt, void* x)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& s = stmts_[stmt];
+    if (type == SQLITE_TRACE_STMT) {
+      // This also comes at the start of each trigger the statement fires.
+      if (s.start == std::chrono::steady_clock::time_point()) {
+        s.start = std::chrono::steady_clock::now();
+      }
+      return 0;
+    }
+
+    // SQLITE_TRACE_PROFILE comes once per run. The slot remembers its
+    // entry, but a finalized statement can leave its address to one with
+    // different SQL text.
+    auto sql = sqlite3_sql(stmt);
+    if (!sql) sql = "";
+    if (!s.e || s.e->sql != sql) {
+      s.e = &entries_[sql];
+      s.e->sql = sql;
+      s.status.fill(0);
+    }
+
+    // SQLite times runs in milliseconds on most platforms, so its figure is
+    // only used if the start of the run was missed.
+    auto ns = static_cast<unsigned long long>(*static_cast<sqlite3_int64*>(x));
+    if (s.start != std::chrono::steady_clock::time_point()) {
+      ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s.start).count();
+      s.start = std::chrono::steady_clock::time_point();
+    }
+
+    auto& e = *s.e;
+    ++e.runs;
+    e.total_ns += ns;
+    e.max_ns = std::max(e.max_ns, ns);
+
+    // The counters are left running for statement::stmt_status(), so only
+    // what they gained since the last run is added.
+    static int const ops[] = {
+      SQLITE_STMTSTATUS_FULLSCAN_STEP, SQLITE_STMTSTATUS_SORT, SQLITE_STMTSTATUS_AUTOINDEX, SQLITE_STMTSTATUS_VM_STEP
+    };
+    unsigned long long* sums[] = { &e.fullscan_steps, &e.sorts, &e.autoindexes, &e.vm_steps };
+    for (std::size_t k = 0; k < s.status.size(); ++k) {
+      auto n = sqlite3_stmt_status(stmt, ops[k], 0);
+      *sums[k] += n >= s.status[k] ? n - s.status[k] : n;
+      s.status[k] = n;
+    }
+
+    std::size_t i = 0;
+    for (auto us = ns / 1000; us > 1 && i + 1 < buckets; us >>= 1) {
+      ++i;
+    }
+    ++e.histogram[i];
+    return 0;
+  }
+
 } // namespace sqlite3pp
@@ -22,6 +22,7 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+#include <algorithm>
 #include <cstring>
 
 #include "sqlite3ppext.h"
@@ -110,6 +111,20 @@ namespace sqlite3pp
       return sqlite3_value_blob(values_[idx]);
     }
 
+    blob_view context::get(int idx, blob_view) const
+    {
+      auto data = sqlite3_value_blob(values_[idx]);
+      return blob_view{data, sqlite3_value_bytes(values_[idx])};
+    }
+
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+    std::string_view context::get(int idx, std::string_view) const
+    {
+      auto text = reinterpret_cast<char const*>(sqlite3_value_text(values_[idx]));
+      return text ? std::string_view(text, sqlite3_value_bytes(values_[idx])) : std::string_view();
+    }
+#endif
+
 
 
     void context::result(int value)
@@ -129,9 +144,16 @@ namespace sqlite3pp
 
     void context::result(std::string const& value)
     {
-      result(value.c_str(), false);
+      sqlite3_result_text(ctx_, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
     }
 
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+    void context::result(std::string_view value)
+    {
+      sqlite3_result_text(ctx_, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+    }
+#endif
+
     void context::result(char const* value, bool fcopy)
     {
       sqlite3_result_text(ctx_, value, std::strlen(value), fcopy ? SQLITE_TRANSIENT : SQLITE_STATIC);
@@ -176,10 +198,11 @@ namespace sqlite3pp
     {
     }
 
-    int function::create(char const* name, function_handler h, int nargs)
+    int function::create(char const* name, function_handler h, int nargs, int flags)
     {
-      fh_[name] = pfunction_base(new function_handler(h));
-      return sqlite3_create_function(db_, name, nargs, SQLITE_UTF8, fh_[name].get(), function_impl, 0, 0);
+      auto& fh = fh_[name];
+      fh = pfunction_base(new function_handler(h));
+      return sqlite3_create_function(db_, name, nargs, SQLITE_UTF8 | flags, fh.get(), function_impl, 0, 0);
     }
 
     aggregate::aggregate(database& db) : db_(db.db_)
@@ -192,6 +215,850 @@ namespace sqlite3pp
       return sqlite3_create_function(db_, name, nargs, SQLITE_UTF8, &ah_[name], 0, step_impl, finalize_impl);
     }
 
+    index_info::index_info(sqlite3_index_info* info) : info_(info), nargs_(0), frejected_(false)
+    {
+    }
+
+    int index_info::constraint_count() const
+    {
+      return info_->nConstraint;
+    }
+
+    int index_info::constraint_column(int i) const
+    {
+      return info_->aConstraint[i].iColumn;
+    }
+
+    int index_info::constraint_op(int i) const
+    {
+      return info_->aConstraint[i].op;
+    }
+
+    bool index_info::constraint_usable(int i) const
+    {
+      return info_->aConstraint[i].usable != 0;
+    }
+
+    void index_info::use(int i, bool fomit)
+    {
+      info_->aConstraintUsage[i].argvIndex = ++nargs_;
+      info_->aConstraintUsage[i].omit = fomit ? 1 : 0;
+    }
+
+    int index_info::orderby_count() const
+    {
+      return info_->nOrderBy;
+    }
+
+    int index_info::orderby_column(int i) const
+    {
+      return info_->aOrderBy[i].iColumn;
+    }
+
+    bool index_info::orderby_desc(int i) const
+    {
+      return info_->aOrderBy[i].desc != 0;
+    }
+
+    void index_info::set_ordered()
+    {
+      info_->orderByConsumed = 1;
+    }
+
+    void index_info::set_index(int num)
+    {
+      info_->idxNum = num;
+    }
+
+    void index_info::set_cost(double cost)
+    {
+      info_->estimatedCost = cost;
+    }
+
+    void index_info::set_rows(long long int rows)
+    {
+#if SQLITE_VERSION_NUMBER >= 3008002
+      info_->estimatedRows = rows;
+#else
+      (void) rows;
+#endif
+    }
+
+    void index_info::reject()
+    {
+      frejected_ = true;
+    }
+
+    bool index_info::rejected() const
+    {
+      return frejected_;
+    }
+
+#ifdef SQLITE_ENABLE_SESSION
+    namespace
+    {
+
+      struct apply_handlers
+      {
+        changeset::conflict_handler const* h;
+        changeset::filter_handler const* f;
+      };
+
+      int filter_impl(void* p, char const* table)
+      {
+        auto hs = static_cast<apply_handlers*>(p);
+        try {
+          return (*hs->f)(table) ? 1 : 0;
+        }
+        catch (...) {
+          return 0;
+        }
+      }
+
+    } // namespace
+
+    changeset::change::change(sqlite3_changeset_iter* it) : it_(it), table_(nullptr), ncols_(0), op_(0), indirect_(0)
+    {
+      if (it_) {
+        sqlite3changeset_op(it_, &table_, &ncols_, &op_, &indirect_);
+      }
+    }
+
+    char const* changeset::change::table() const
+    {
+      return table_;
+    }
+
+    int changeset::change::op() const
+    {
+      return op_;
+    }
+
+    bool changeset::change::indirect() const
+    {
+      return indirect_ != 0;
+    }
+
+    int changeset::change::column_count() const
+    {
+      return ncols_;
+    }
+
+    sqlite3_value* changeset::change::old_value(int idx) const
+    {
+      sqlite3_value* v = nullptr;
+      if (op_ != SQLITE_INSERT) sqlite3changeset_old(it_, idx, &v);
+      return v;
+    }
+
+    sqlite3_value* changeset::change::new_value(int idx) const
+    {
+      sqlite3_value* v = nullptr;
+      if (op_ != SQLITE_DELETE) sqlite3changeset_new(it_, idx, &v);
+      return v;
+    }
+
+    sqlite3_value* changeset::change::conflict_value(int idx) const
+    {
+      sqlite3_value* v = nullptr;
+      sqlite3changeset_conflict(it_, idx, &v);
+      return v;
+    }
+
+    int changeset::change::get(sqlite3_value* v, int)
+    {
+      return sqlite3_value_int(v);
+    }
+
+    double changeset::change::get(sqlite3_value* v, double)
+    {
+      return sqlite3_value_double(v);
+    }
+
+    long long int changeset::change::get(sqlite3_value* v, long long int)
+    {
+      return sqlite3_value_int64(v);
+    }
+
+    char const* changeset::change::get(sqlite3_value* v, char const*)
+    {
+      return reinterpret_cast<char const*>(sqlite3_value_text(v));
+    }
+
+    std::string changeset::change::get(sqlite3_value* v, std::string)
+    {
+      auto p = reinterpret_cast<char const*>(sqlite3_value_text(v));
+      return p ? std::string(p, sqlite3_value_bytes(v)) : std::string();
+    }
+
+    blob_view changeset::change::get(sqlite3_value* v, blob_view)
+    {
+      auto data = sqlite3_value_blob(v);
+      return blob_view{data, sqlite3_value_bytes(v)};
+    }
+
+    changeset::iterator::iterator()
+    {
+    }
+
+    changeset::iterator::iterator(changeset const* cs)
+    {
+      sqlite3_changeset_iter* it = nullptr;
+      if (sqlite3changeset_start(&it, cs->size_, cs->data_) != SQLITE_OK)
+        throw database_error("corrupt changeset");
+      it_.reset(it, sqlite3changeset_finalize);
+      ++(*this);
+    }
+
+    bool changeset::iterator::operator==(iterator const& other) const
+    {
+      return it_ == other.it_;
+    }
+
+    bool changeset::iterator::operator!=(iterator const& other) const
+    {
+      return !(*this == other);
+    }
+
+    changeset::iterator& changeset::iterator::operator++()
+    {
+      auto rc = sqlite3changeset_next(it_.get());
+      if (rc == SQLITE_ROW) {
+        c_ = change(it_.get());
+        return *this;
+      }
+      it_.reset();
+      c_ = change();
+      if (rc != SQLITE_DONE)
+        throw database_error("corrupt changeset");
+      return *this;
+    }
+
+    changeset::iterator::reference changeset::iterator::operator*() const
+    {
+      return c_;
+    }
+
+    changeset::iterator::pointer changeset::iterator::operator->() const
+    {
+      return &c_;
+    }
+
+    changeset::changeset() : data_(nullptr), size_(0)
+    {
+    }
+
+    changeset::changeset(void const* data, int n) : data_(nullptr), size_(n)
+    {
+      if (n > 0) {
+        data_ = sqlite3_malloc(n);
+        if (!data_) throw std::bad_alloc();
+        std::memcpy(data_, data, n);
+      }
+    }
+
+    changeset::changeset(changeset&& cs) : data_(cs.data_), size_(cs.size_)
+    {
+      cs.data_ = nullptr;
+      cs.size_ = 0;
+    }
+
+    changeset& changeset::operator=(changeset&& cs)
+    {
+      if (this != &cs) {
+        clear();
+        data_ = cs.data_;
+        size_ = cs.size_;
+        cs.data_ = nullptr;
+        cs.size_ = 0;
+      }
+      return *this;
+    }
+
+    changeset::~changeset()
+    {
+      clear();
+    }
+
+    void const* changeset::data() const
+    {
+      return data_;
+    }
+
+    int changeset::size() const
+    {
+      return size_;
+    }
+
+    bool changeset::empty() const
+    {
+      return size_ == 0;
+    }
+
+    changeset::iterator changeset::begin() const
+    {
+      return iterator(this);
+    }
+
+    changeset::iterator changeset::end() const
+    {
+      return iterator();
+    }
+
+    int changeset::invert(changeset& out) const
+    {
+      int n = 0;
+      void* p = nullptr;
+      auto rc = sqlite3changeset_invert(size_, data_, &n, &p);
+      if (rc == SQLITE_OK) {
+        out.clear();
+        out.data_ = p;
+        out.size_ = n;
+      }
+      return rc;
+    }
+
+    int changeset::concat(changeset const& other, changeset& out) const
+    {
+      int n = 0;
+      void* p = nullptr;
+      auto rc = sqlite3changeset_concat(size_, data_, other.size_, other.data_, &n, &p);
+      if (rc == SQLITE_OK) {
+        out.clear();
+        out.data_ = p;
+        out.size_ = n;
+      }
+      return rc;
+    }
+
+    int changeset::apply(database& db, conflict_handler h, filter_handler f) const
+    {
+      apply_handlers hs{&h, &f};
+      return sqlite3changeset_apply(db.db_, size_, data_, f ? filter_impl : nullptr, conflict_impl, &hs);
+    }
+
+    int changeset::conflict_impl(void* p, int type, sqlite3_changeset_iter* it)
+    {
+      auto hs = static_cast<apply_handlers*>(p);
+      if (!*hs->h) return SQLITE_CHANGESET_ABORT;
+      try {
+        return (*hs->h)(type, change(it));
+      }
+      catch (...) {
+        return SQLITE_CHANGESET_ABORT;
+      }
+    }
+
+    void changeset::clear()
+    {
+      sqlite3_free(data_);
+      data_ = nullptr;
+      size_ = 0;
+    }
+
+    session::session(database& db, char const* dbname) : s_(nullptr)
+    {
+      if (sqlite3session_create(db.db_, dbname, &s_) != SQLITE_OK)
+        throw database_error(db);
+    }
+
+    session::~session()
+    {
+      sqlite3session_delete(s_);
+    }
+
+    int session::attach(char const* table)
+    {
+      return sqlite3session_attach(s_, table);
+    }
+
+    void session::enable(bool fenable)
+    {
+      sqlite3session_enable(s_, fenable ? 1 : 0);
+    }
+
+    bool session::enabled() const
+    {
+      return sqlite3session_enable(s_, -1) != 0;
+    }
+
+    bool session::empty() const
+    {
+      return sqlite3session_isempty(s_) != 0;
+    }
+
+    int session::changeset(ext::changeset& cs) const
+    {
+      ext::changeset out;
+      auto rc = sqlite3session_changeset(s_, &out.size_, &out.data_);
+      if (rc == SQLITE_OK) cs = std::move(out);
+      return rc;
+    }
+
+    int session::patchset(ext::changeset& cs) const
+    {
+      ext::changeset out;
+      auto rc = sqlite3session_patchset(s_, &out.size_, &out.data_);
+      if (rc == SQLITE_OK) cs = std::move(out);
+      return rc;
+    }
+#endif
+
+    struct vfs_impl
+    {
+      // What SQLite allocates for a file: the header it sees, then the file
+      // of the base VFS.
+      struct handle
+      {
+        sqlite3_file header;
+        vfs::file* f;
+      };
+
+      static std::size_t base_offset() {
+        auto align = alignof(std::max_align_t);
+        return (sizeof(handle) + align - 1) / align * align;
+      }
+
+      static sqlite3_file* base_file(sqlite3_file* p) {
+        return reinterpret_cast<sqlite3_file*>(reinterpret_cast<char*>(p) + base_offset());
+      }
+
+      static vfs::file* self(sqlite3_file* p) {
+        return reinterpret_cast<handle*>(p)->f;
+      }
+
+      static vfs* owner(sqlite3_vfs* v) {
+        return static_cast<vfs*>(v->pAppData);
+      }
+
+      static int close(sqlite3_file* p) {
+        auto f = self(p);
+        auto rc = f->close();
+        delete f;
+        return rc;
+      }
+      static int read(sqlite3_file* p, void* data, int n, sqlite3_int64 off) {
+        return self(p)->read(data, n, off);
+      }
+      static int write(sqlite3_file* p, void const* data, int n, sqlite3_int64 off) {
+        return self(p)->write(data, n, off);
+      }
+      static int truncate(sqlite3_file* p, sqlite3_int64 size) {
+        return self(p)->truncate(size);
+      }
+      static int sync(sqlite3_file* p, int flags) {
+        return self(p)->sync(flags);
+      }
+      static int file_size(sqlite3_file* p, sqlite3_int64* size) {
+        return self(p)->file_size(*size);
+      }
+      static int lock(sqlite3_file* p, int level) {
+        return self(p)->lock(level);
+      }
+      static int unlock(sqlite3_file* p, int level) {
+        return self(p)->unlock(level);
+      }
+      static int check_reserved_lock(sqlite3_file* p, int* reserved) {
+        return self(p)->check_reserved_lock(*reserved);
+      }
+      static int file_control(sqlite3_file* p, int op, void* arg) {
+        return self(p)->file_control(op, arg);
+      }
+      static int sector_size(sqlite3_file* p) {
+        return self(p)->sector_size();
+      }
+      static int device_characteristics(sqlite3_file* p) {
+        return self(p)->device_characteristics();
+      }
+      static int shm_map(sqlite3_file* p, int region, int size, int extend, void volatile** pp) {
+        return self(p)->shm_map(region, size, extend != 0, pp);
+      }
+      static int shm_lock(sqlite3_file* p, int offset, int n, int flags) {
+        return self(p)->shm_lock(offset, n, flags);
+      }
+      static void shm_barrier(sqlite3_file* p) {
+        self(p)->shm_barrier();
+      }
+      static int shm_unmap(sqlite3_file* p, int fdelete) {
+        return self(p)->shm_unmap(fdelete != 0);
+      }
+      static int fetch(sqlite3_file* p, sqlite3_int64 off, int n, void** pp) {
+        return self(p)->fetch(off, n, pp);
+      }
+      static int unfetch(sqlite3_file* p, sqlite3_int64 off, void* ptr) {
+        return self(p)->unfetch(off, ptr);
+      }
+
+      // Files get the methods of the version their base file has, so SQLite
+      // doesn't ask for shared memory or mmap that isn't there.
+      static sqlite3_io_methods const* methods(int version) {
+        static sqlite3_io_methods const v1 = {
+          1, close, read, write, truncate, sync, file_size, lock, unlock, check_reserved_lock,
+          file_control, sector_size, device_characteristics, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr
+        };
+        static sqlite3_io_methods const v2 = {
+          2, close, read, write, truncate, sync, file_size, lock, unlock, check_reserved_lock,
+          file_control, sector_size, device_characteristics, shm_map, shm_lock, shm_barrier, shm_unmap, nullptr, nullptr
+        };
+        static sqlite3_io_methods const v3 = {
+          3, close, read, write, truncate, sync, file_size, lock, unlock, check_reserved_lock,
+          file_control, sector_size, device_characteristics, shm_map, shm_lock, shm_barrier, shm_unmap, fetch, unfetch
+        };
+        return version >= 3 ? &v3 : version == 2 ? &v2 : &v1;
+      }
+
+      static int open(sqlite3_vfs* v, char const* name, sqlite3_file* p, int flags, int* outflags) {
+        auto h = reinterpret_cast<handle*>(p);
+        h->header.pMethods = nullptr;
+        h->f = nullptr;
+
+        auto base = base_file(p);
+        auto bv = owner(v)->base_;
+        auto rc = bv->xOpen(bv, name, base, flags, outflags);
+        if (rc != SQLITE_OK || !base->pMethods) {
+          if (base->pMethods) base->pMethods->xClose(base);
+          return rc != SQLITE_OK ? rc : SQLITE_CANTOPEN;
+        }
+
+        try {
+          h->f = owner(v)->open(name, flags, base).release();
+        }
+        catch (...) {
+        }
+        if (!h->f) {
+          base->pMethods->xClose(base);
+          return SQLITE_NOMEM;
+        }
+        h->header.pMethods = methods(base->pMethods->iVersion);
+        return SQLITE_OK;
+      }
+
+      static int remove(sqlite3_vfs* v, char const* name, int fsync) {
+        auto bv = owner(v)->base_;
+        return bv->xDelete(bv, name, fsync);
+      }
+      static int access(sqlite3_vfs* v, char const* name, int flags, int* out) {
+        auto bv = owner(v)->base_;
+        return bv->xAccess(bv, name, flags, out);
+      }
+      static int full_pathname(sqlite3_vfs* v, char const* name, int n, char* out) {
+        auto bv = owner(v)->base_;
+        return bv->xFullPathname(bv, name, n, out);
+      }
+      static void* dl_open(sqlite3_vfs* v, char const* name) {
+        auto bv = owner(v)->base_;
+        return bv->xDlOpen(bv, name);
+      }
+      static void dl_error(sqlite3_vfs* v, int n, char* msg) {
+        auto bv = owner(v)->base_;
+        bv->xDlError(bv, n, msg);
+      }
+      static void (*dl_sym(sqlite3_vfs* v, void* lib, char const* sym))(void) {
+        auto bv = owner(v)->base_;
+        return bv->xDlSym(bv, lib, sym);
+      }
+      static void dl_close(sqlite3_vfs* v, void* lib) {
+        auto bv = owner(v)->base_;
+        bv->xDlClose(bv, lib);
+      }
+      static int randomness(sqlite3_vfs* v, int n, char* out) {
+        auto bv = owner(v)->base_;
+        return bv->xRandomness(bv, n, out);
+      }
+      static int sleep(sqlite3_vfs* v, int us) {
+        auto bv = owner(v)->base_;
+        return bv->xSleep(bv, us);
+      }
+      static int current_time(sqlite3_vfs* v, double* out) {
+        auto bv = owner(v)->base_;
+        return bv->xCurrentTime(bv, out);
+      }
+      static int get_last_error(sqlite3_vfs* v, int n, char* out) {
+        auto bv = owner(v)->base_;
+        return bv->xGetLastError ? bv->xGetLastError(bv, n, out) : 0;
+      }
+      static int current_time_int64(sqlite3_vfs* v, sqlite3_int64* out) {
+        auto bv = owner(v)->base_;
+        return bv->xCurrentTimeInt64(bv, out);
+      }
+      static int set_system_call(sqlite3_vfs* v, char const* name, sqlite3_syscall_ptr f) {
+        auto bv = owner(v)->base_;
+        return bv->xSetSystemCall(bv, name, f);
+      }
+      static sqlite3_syscall_ptr get_system_call(sqlite3_vfs* v, char const* name) {
+        auto bv = owner(v)->base_;
+        return bv->xGetSystemCall(bv, name);
+      }
+      static char const* next_system_call(sqlite3_vfs* v, char const* name) {
+        auto bv = owner(v)->base_;
+        return bv->xNextSystemCall(bv, name);
+      }
+    };
+
+    vfs::file::file(sqlite3_file* base) : base_(base)
+    {
+    }
+
+    vfs::file::~file()
+    {
+    }
+
+    int vfs::file::close()
+    {
+      return base_->pMethods->xClose(base_);
+    }
+
+    int vfs::file::read(void* data, int n, sqlite3_int64 off)
+    {
+      return base_->pMethods->xRead(base_, data, n, off);
+    }
+
+    int vfs::file::write(void const* data, int n, sqlite3_int64 off)
+    {
+      return base_->pMethods->xWrite(base_, data, n, off);
+    }
+
+    int vfs::file::truncate(sqlite3_int64 size)
+    {
+      return base_->pMethods->xTruncate(base_, size);
+    }
+
+    int vfs::file::sync(int flags)
+    {
+      return base_->pMethods->xSync(base_, flags);
+    }
+
+    int vfs::file::file_size(sqlite3_int64& size)
+    {
+      return base_->pMethods->xFileSize(base_, &size);
+    }
+
+    int vfs::file::lock(int level)
+    {
+      return base_->pMethods->xLock(base_, level);
+    }
+
+    int vfs::file::unlock(int level)
+    {
+      return base_->pMethods->xUnlock(base_, level);
+    }
+
+    int vfs::file::check_reserved_lock(int& reserved)
+    {
+      return base_->pMethods->xCheckReservedLock(base_, &reserved);
+    }
+
+    int vfs::file::file_control(int op, void* arg)
+    {
+      return base_->pMethods->xFileControl(base_, op, arg);
+    }
+
+    int vfs::file::sector_size()
+    {
+      return base_->pMethods->xSectorSize(base_);
+    }
+
+    int vfs::file::device_characteristics()
+    {
+      return base_->pMethods->xDeviceCharacteristics(base_);
+    }
+
+    int vfs::file::shm_map(int region, int size, bool fextend, void volatile** pp)
+    {
+      return base_->pMethods->xShmMap(base_, region, size, fextend ? 1 : 0, pp);
+    }
+
+    int vfs::file::shm_lock(int offset, int n, int flags)
+    {
+      return base_->pMethods->xShmLock(base_, offset, n, flags);
+    }
+
+    void vfs::file::shm_barrier()
+    {
+      base_->pMethods->xShmBarrier(base_);
+    }
+
+    int vfs::file::shm_unmap(bool fdelete)
+    {
+      return base_->pMethods->xShmUnmap(base_, fdelete ? 1 : 0);
+    }
+
+    int vfs::file::fetch(sqlite3_int64 off, int n, void** pp)
+    {
+      return base_->pMethods->xFetch(base_, off, n, pp);
+    }
+
+    int vfs::file::unfetch(sqlite3_int64 off, void* p)
+    {
+      return base_->pMethods->xUnfetch(base_, off, p);
+    }
+
+    vfs::vfs(char const* name, char const* base, bool fdefault) : name_(name), base_(sqlite3_vfs_find(base))
+    {
+      if (!base_)
+        throw database_error("no such vfs");
+
+      vfs_ = sqlite3_vfs();
+      vfs_.iVersion = std::min(base_->iVersion, 3);
+      vfs_.szOsFile = static_cast<int>(vfs_impl::base_offset()) + base_->szOsFile;
+      vfs_.mxPathname = base_->mxPathname;
+      vfs_.zName = name_.c_str();
+      vfs_.pAppData = this;
+      vfs_.xOpen = vfs_impl::open;
+      vfs_.xDelete = vfs_impl::remove;
+      vfs_.xAccess = vfs_impl::access;
+      vfs_.xFullPathname = vfs_impl::full_pathname;
+      vfs_.xDlOpen = vfs_impl::dl_open;
+      vfs_.xDlError = vfs_impl::dl_error;
+      vfs_.xDlSym = vfs_impl::dl_sym;
+      vfs_.xDlClose = vfs_impl::dl_close;
+      vfs_.xRandomness = vfs_impl::randomness;
+      vfs_.xSleep = vfs_impl::sleep;
+      vfs_.xCurrentTime = vfs_impl::current_time;
+      vfs_.xGetLastError = vfs_impl::get_last_error;
+      if (vfs_.iVersion >= 2) {
+        vfs_.xCurrentTimeInt64 = vfs_impl::current_time_int64;
+      }
+      if (vfs_.iVersion >= 3) {
+        vfs_.xSetSystemCall = vfs_impl::set_system_call;
+        vfs_.xGetSystemCall = vfs_impl::get_system_call;
+        vfs_.xNextSystemCall = vfs_impl::next_system_call;
+      }
+
+      if (sqlite3_vfs_register(&vfs_, fdefault ? 1 : 0) != SQLITE_OK)
+        throw database_error("can't register vfs");
+    }
+
+    vfs::~vfs()
+    {
+      sqlite3_vfs_unregister(&vfs_);
+    }
+
+    char const* vfs::name() const
+    {
+      return name_.c_str();
+    }
+
+    std::unique_ptr<vfs::file> vfs::open(char const* /*name*/, int /*flags*/, sqlite3_file* base)
+    {
+      return std::unique_ptr<file>(new file(base));
+    }
+
+    class readahead_vfs::readahead_file : public vfs::file
+    {
+     public:
+      readahead_file(sqlite3_file* base, readahead_vfs& v) : file(base), v_(v), off_(0), len_(0), next_(-1), nseq_(0)
+      {
+      }
+
+      int read(void* data, int n, sqlite3_int64 off) override
+      {
+        if (len_ > 0 && off >= off_ && off + n <= off_ + len_) {
+          std::memcpy(data, buf_.data() + (off - off_), n);
+          next_ = off + n;
+          ++v_.hits_;
+          return SQLITE_OK;
+        }
+
+        // Only the third read in a row that starts where the last one
+        // ended fills the buffer, so random lookups read just their page.
+        nseq_ = off == next_ ? nseq_ + 1 : 0;
+        next_ = off + n;
+        if (nseq_ < 2 || static_cast<std::size_t>(n) >= v_.readahead_)
+          return file::read(data, n, off);
+
+        sqlite3_int64 size = 0;
+        if (file::file_size(size) != SQLITE_OK || size - off < n)
+          return file::read(data, n, off);
+
+        auto len = static_cast<int>(std::min<sqlite3_int64>(v_.readahead_, size - off));
+        try {
+          buf_.resize(v_.readahead_);
+        }
+        catch (...) {
+          return file::read(data, n, off);
+        }
+        len_ = 0;
+        auto rc = file::read(buf_.data(), len, off);
+        if (rc != SQLITE_OK)
+          return file::read(data, n, off);
+
+        off_ = off;
+        len_ = len;
+        ++v_.fills_;
+        std::memcpy(data, buf_.data(), n);
+        return SQLITE_OK;
+      }
+
+      int write(void const* data, int n, sqlite3_int64 off) override
+      {
+        len_ = 0;
+        return file::write(data, n, off);
+      }
+
+      int truncate(sqlite3_int64 size) override
+      {
+        len_ = 0;
+        return file::truncate(size);
+      }
+
+      int lock(int level) override
+      {
+        len_ = 0;
+        return file::lock(level);
+      }
+
+      int unlock(int level) override
+      {
+        len_ = 0;
+        return file::unlock(level);
+      }
+
+      // A WAL reader keeps its lock on the database file from transaction
+      // to transaction, but locks a read mark in the WAL index for each.
+      int shm_lock(int offset, int n, int flags) override
+      {
+        len_ = 0;
+        return file::shm_lock(offset, n, flags);
+      }
+
+      void shm_barrier() override
+      {
+        len_ = 0;
+        file::shm_barrier();
+      }
+
+     private:
+      readahead_vfs& v_;
+      std::vector<char> buf_;
+      sqlite3_int64 off_;
+      int len_;
+      sqlite3_int64 next_;
+      int nseq_;
+    };
+
+    readahead_vfs::readahead_vfs(char const* name, std::size_t readahead, char const* base, bool fdefault) :
+      vfs(name, base, fdefault), readahead_(readahead), hits_(0), fills_(0)
+    {
+    }
+
+    unsigned long long readahead_vfs::hits() const
+    {
+      return hits_;
+    }
+
+    unsigned long long readahead_vfs::fills() const
+    {
+      return fills_;
+    }
+
+    std::unique_ptr<vfs::file> readahead_vfs::open(char const* name, int flags, sqlite3_file* base)
+    {
+      if (readahead_ == 0 || !(flags & SQLITE_OPEN_MAIN_DB))
+        return vfs::open(name, flags, base);
+      return std::unique_ptr<file>(new readahead_file(base, *this));
+    }
+
   } // namespace ext
 
 } // namespace sqlite3pp
@@ -0,0 +1,624 @@
+// sqlite3ppthread.h
+//
+// The MIT License
+//
+// Copyright (c) 2015 Wongoo Lee (iwongu at gmail dot com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef SQLITE3PPTHREAD_H
+#define SQLITE3PPTHREAD_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "sqlite3pp.h"
+
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+#define SQLITE3PP_HAS_COROUTINES
+#include <coroutine>
+#include <optional>
+#endif
+
+namespace sqlite3pp
+{
+
+  class connection_pool : noncopyable
+  {
+   public:
+    class lease : noncopyable
+    {
+      friend class connection_pool;
+
+     public:
+      lease(lease&& l);
+      lease& operator=(lease&& l);
+      ~lease();
+
+      database& db() const;
+      database& operator*() const;
+      database* operator->() const;
+
+      void release();
+
+     private:
+      lease(connection_pool* pool, std::size_t slot);
+
+      connection_pool* pool_;
+      std::size_t slot_;
+    };
+
+    // Opens one writer and nreaders read-only connections to dbname, which
+    // is switched to WAL mode so that readers don't block the writer. Each
+    // connection keeps its own statement cache of cache_capacity entries.
+    explicit connection_pool(char const* dbname, std::size_t nreaders = 4, std::size_t cache_capacity = 32, int busy_timeout = 5000, char const* vfs = nullptr);
+    ~connection_pool();
+
+    // Both block until a connection is free. A thread gets back the reader
+    // it used last time if it is free, so its prepared statements are warm.
+    lease reader();
+    lease writer();
+
+    std::size_t readers() const;
+
+   private:
+    struct slot
+    {
+      database db;
+      bool busy;
+      std::thread::id owner;
+    };
+
+    void release(std::size_t slot);
+
+   private:
+    std::vector<std::unique_ptr<slot>> slots_;
+    std::mutex mutex_;
+    std::condition_variable readers_cv_;
+    std::condition_variable writer_cv_;
+  };
+
+  // Runs a backup_job on its own thread. The source and destination
+  // databases must not be used by other threads until wait() returns.
+  class backup_thread : noncopyable
+  {
+   public:
+    explicit backup_thread(backup_job& job);
+
+    // Cancels the job if it is still running.
+    ~backup_thread();
+
+    // Blocks until the job is done and returns the result of its run().
+    int wait();
+    void cancel();
+
+    bool running() const;
+
+   private:
+    backup_job& job_;
+    std::atomic<bool> running_;
+    int rc_;
+    std::thread thread_;
+  };
+
+  // Group commit. Jobs submitted from any thread are run by one writer
+  // thread, up to max_batch of them in a single transaction. The writer
+  // waits up to max_delay after the first job of a batch for more jobs to
+  // arrive. Each job runs in its own savepoint, so a job that fails or
+  // throws is rolled back alone, and its future gets its own result. The
+  // database must not be used by other threads while the scheduler runs.
+  class write_scheduler : noncopyable
+  {
+   public:
+    using job = std::function<int (database&)>;
+
+    explicit write_scheduler(database& db, std::size_t max_batch = 1000, std::chrono::milliseconds max_delay = std::chrono::milliseconds(0));
+
+    // Runs the jobs that are already queued, then stops.
+    ~write_scheduler();
+
+    // The future gets the job's result, or the COMMIT's if that fails.
+    std::future<int> submit(job j);
+
+    // Executes and resets cmd, which must stay alive and keep its bindings
+    // until the future is ready.
+    std::future<int> submit(command& cmd);
+
+    void stop();
+
+    unsigned long long batches() const;
+    unsigned long long jobs() const;
+
+   private:
+    struct item
+    {
+      job j;
+      std::promise<int> p;
+    };
+
+    void run();
+    void run_batch(std::vector<item>& batch);
+
+   private:
+    database& db_;
+    std::size_t max_batch_;
+    std::chrono::milliseconds max_delay_;
+    std::deque<item> queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+    std::atomic<unsigned long long> batches_;
+    std::atomic<unsigned long long> jobs_;
+    std::thread thread_;
+  };
+
+  // A feed of the rows changed through db, one batch per committed
+  // transaction. It owns the update, commit and rollback handlers of db.
+  // The writer only appends to a buffer, which a rollback empties and a
+  // commit pushes into a ring of capacity batches without taking a lock.
+  // The consumer gets the batches in commit order on a thread of its own.
+  // If the ring is full, the commit sleeps until the consumer frees a
+  // slot, and stalls() counts it. The set of
+  // changes is a superset: rows undone by ROLLBACK TO are kept, and so is
+  // a batch whose COMMIT fails after the commit handler has run. Changes
+  // SQLite doesn't report to update handlers, such as to WITHOUT ROWID
+  // tables, are missed.
+  class change_feed : noncopyable
+  {
+   public:
+    struct change
+    {
+      int op; // SQLITE_INSERT, SQLITE_UPDATE or SQLITE_DELETE
+      char const* dbname;
+      char const* table;
+      long long int rowid;
+    };
+
+    // The names in the changes stay valid while the feed lives.
+    using consumer = std::function<void (std::vector<change> const&)>;
+
+    // Each buffer starts with room for reserve changes and keeps the room
+    // it grows to.
+    explicit change_feed(database& db, consumer c, std::size_t capacity = 64, std::size_t reserve = 1024);
+
+    // Removes the handlers and waits for the consumer to finish the
+    // batches already committed.
+    ~change_feed();
+
+    unsigned long long batches() const;
+    unsigned long long changes() const;
+    unsigned long long stalls() const;
+
+   private:
+    char const* intern(char const* name);
+    void publish();
+    void run();
+
+   private:
+    database& db_;
+    consumer c_;
+    std::vector<change> pending_;
+    std::deque<std::string> names_;
+    std::vector<std::vector<change>> ring_;
+    std::atomic<std::size_t> head_;
+    std::atomic<std::size_t> tail_;
+    std::atomic<bool> sleeping_;
+    std::atomic<bool> blocked_;
+    std::atomic<bool> stop_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::atomic<unsigned long long> batches_;
+    std::atomic<unsigned long long> changes_;
+    std::atomic<unsigned long long> stalls_;
+    std::thread thread_;
+  };
+
+  // A connection per shard file, and a pool of threads that runs the same
+  // query on all of them at once. The statements stay prepared in each
+  // shard's statement cache of cache_capacity entries. nthreads defaults
+  // to one per core, up to one per shard. Calls block until every shard is
+  // done, and rethrow the first error of a shard. They must not be made
+  // from the callbacks they run.
+  class shard_set : noncopyable
+  {
+   public:
+    static constexpr std::size_t batch_rows = 1024;
+
+    explicit shard_set(std::vector<std::string> const& files, std::size_t nthreads = 0, std::size_t cache_capacity = 32, int flags = SQLITE_OPEN_READONLY, char const* vfs = nullptr);
+    ~shard_set();
+
+    std::size_t size() const;
+    database& shard(std::size_t i);
+
+    // Runs f(db, i) for each shard i, each shard on one thread at a time.
+    void for_each(std::function<void (database&, std::size_t)> f);
+
+    // The rows of all the shards, shard by shard. Ts must hold their
+    // values, like they would for query_one().
+    template <class... Ts, class... As>
+    std::vector<std::tuple<Ts...>> select(char const* sql, As const&... args) {
+      std::vector<std::vector<std::tuple<Ts...>>> parts(size());
+      scan<Ts...>([&](std::size_t i, std::tuple<Ts...> const& row) { parts[i].push_back(row); }, sql, args...);
+
+      std::vector<std::tuple<Ts...>> rows;
+      for (auto& part : parts) {
+        rows.insert(rows.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+      }
+      return rows;
+    }
+
+    // For sql with an ORDER BY that less agrees with. The rows of each
+    // shard come sorted, so they are merged rather than sorted again.
+    template <class... Ts, class Less, class... As>
+    std::vector<std::tuple<Ts...>> select_sorted(Less less, char const* sql, As const&... args) {
+      std::vector<std::vector<std::tuple<Ts...>>> parts(size());
+      scan<Ts...>([&](std::size_t i, std::tuple<Ts...> const& row) { parts[i].push_back(row); }, sql, args...);
+
+      std::vector<std::tuple<Ts...>> rows;
+      std::vector<std::size_t> bounds(1, 0);
+      for (auto& part : parts) {
+        rows.insert(rows.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+        bounds.push_back(rows.size());
+      }
+      for (std::size_t width = 1; width < parts.size(); width *= 2) {
+        for (std::size_t i = 0; i + width < parts.size(); i += 2 * width) {
+          auto last = std::min(i + 2 * width, parts.size());
+          std::inplace_merge(rows.begin() + bounds[i], rows.begin() + bounds[i + width], rows.begin() + bounds[last], less);
+        }
+      }
+      return rows;
+    }
+
+    // Calls f(i, rows) with batches of up to batch_rows rows as shards
+    // produce them, one call at a time, so the first rows don't wait for
+    // the slowest shard.
+    template <class... Ts, class F, class... As>
+    void stream(F f, char const* sql, As const&... args) {
+      std::mutex m;
+      for_each([&](database& db, std::size_t i) {
+        std::vector<std::tuple<Ts...>> rows;
+        rows.reserve(batch_rows);
+        auto flush = [&] {
+          std::lock_guard<std::mutex> lock(m);
+          f(i, rows);
+          rows.clear();
+        };
+        fetch<Ts...>(db, [&](std::tuple<Ts...> const& row) {
+          rows.push_back(row);
+          if (rows.size() == batch_rows) flush();
+        }, sql, args...);
+        if (!rows.empty()) flush();
+      });
+    }
+
+    // Combines the one-row results of sql, such as partial aggregates, in
+    // shard order with combine(total, row). Shards without a row are
+    // skipped. Throws database_error if no shard has one.
+    template <class... Ts, class Combine, class... As>
+    std::tuple<Ts...> reduce(Combine combine, char const* sql, As const&... args) {
+      auto rows = select<Ts...>(sql, args...);
+      if (rows.empty())
+        throw database_error("reduce: no rows");
+      auto total = rows.front();
+      for (std::size_t i = 1; i < rows.size(); ++i) {
+        total = combine(total, rows[i]);
+      }
+      return total;
+    }
+
+   private:
+    struct slot
+    {
+      database db;
+      std::mutex mutex;
+    };
+
+    template <class... Ts, class F, class... As>
+    static void fetch(database& db, F f, char const* sql, As const&... args) {
+      static_assert(no_views<Ts...>::value, "shard_set needs row types that hold their values");
+      query qry(db, sql);
+      if (qry.bind_args(1, args...) != SQLITE_OK)
+        throw database_error(db);
+      for (auto const& row : qry.as<Ts...>()) {
+        f(row);
+      }
+    }
+
+    template <class... Ts, class F, class... As>
+    void scan(F f, char const* sql, As const&... args) {
+      for_each([&](database& db, std::size_t i) {
+        fetch<Ts...>(db, [&](std::tuple<Ts...> const& row) { f(i, row); }, sql, args...);
+      });
+    }
+
+    template <class... Ts>
+    struct no_views : std::true_type {};
+
+    template <class T, class... Ts>
+    struct no_views<T, Ts...> : std::integral_constant<bool, !is_view<T>::value && no_views<Ts...>::value> {};
+
+    void loop();
+
+   private:
+    std::vector<std::unique_ptr<slot>> shards_;
+    std::deque<std::function<void ()>> queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+    std::vector<std::thread> threads_;
+  };
+
+  // A busy handler that waits about initial, doubling up to max_delay,
+  // with jitter so that the connections it holds up don't retry in step.
+  // It gives up once a lock has been busy for timeout. One handler can
+  // serve many connections on many threads:
+  //   db.set_busy_handler(std::ref(backoff));
+  class busy_backoff : noncopyable
+  {
+   public:
+    explicit busy_backoff(std::chrono::microseconds initial = std::chrono::microseconds(100),
+                          std::chrono::microseconds max_delay = std::chrono::milliseconds(20),
+                          std::chrono::milliseconds timeout = std::chrono::milliseconds(5000));
+
+    int operator()(int count);
+
+    // Locks found busy, waits, locks given up, and the time spent waiting.
+    unsigned long long contentions() const;
+    unsigned long long retries() const;
+    unsigned long long timeouts() const;
+    std::chrono::microseconds waited() const;
+
+   private:
+    std::chrono::microseconds initial_;
+    std::chrono::microseconds max_delay_;
+    std::chrono::milliseconds timeout_;
+    std::atomic<unsigned long long> contentions_;
+    std::atomic<unsigned long long> retries_;
+    std::atomic<unsigned long long> timeouts_;
+    std::atomic<long long int> waited_;
+  };
+
+  // Takes the checkpoints of a WAL database off its writers, onto a
+  // connection of its own. It checkpoints when a commit leaves
+  // passive_pages in the WAL, and every interval while any are left. When
+  // readers keep a checkpoint from the end of a WAL of restart_pages, it's
+  // redone as a RESTART, and from truncate_pages as a TRUNCATE, which also
+  // shrinks the file. Those wait up to busy_timeout ms for the readers,
+  // and hold up the writers meanwhile. SQLite's automatic checkpoints are
+  // off while the scheduler lives.
+  class checkpoint_scheduler : noncopyable
+  {
+   public:
+    struct options
+    {
+      int passive_pages = 1000;
+      int restart_pages = 4000;
+      int truncate_pages = 16000;
+      int busy_timeout = 100;
+      std::chrono::milliseconds interval = std::chrono::milliseconds(1000);
+    };
+
+    explicit checkpoint_scheduler(database& db);
+    checkpoint_scheduler(database& db, options const& opts);
+
+    // Turns the automatic checkpoints of db back on, as they were before.
+    ~checkpoint_scheduler();
+
+    unsigned long long checkpoints() const;
+    unsigned long long restarts() const;
+    unsigned long long truncates() const;
+
+    // Checkpoints that returned SQLITE_BUSY.
+    unsigned long long busy() const;
+
+   private:
+    void checkpoint();
+    void run();
+
+   private:
+    database& db_;
+    options opts_;
+    database ckptdb_;
+    int autocheckpoint_;
+    std::atomic<int> pages_;
+    std::atomic<bool> due_;
+    bool stop_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::atomic<unsigned long long> checkpoints_;
+    std::atomic<unsigned long long> restarts_;
+    std::atomic<unsigned long long> truncates_;
+    std::atomic<unsigned long long> busy_;
+    std::thread thread_;
+  };
+
+#ifdef SQLITE3PP_HAS_COROUTINES
+  template <class R, class F = std::function<R (database&)>> class awaitable;
+#endif
+
+  // Runs jobs on db from a thread of its own, in the order they are posted,
+  // so that waits for I/O, locks and long queries don't block the caller.
+  // db must not be used by other threads while the executor runs. With
+  // C++20, jobs can be awaited from coroutines too. They resume through
+  // dispatch, or on the executor thread if there is none.
+  class executor : noncopyable
+  {
+    template <class R, class F> friend class awaitable;
+
+   public:
+    using dispatcher = std::function<void (std::function<void ()>)>;
+
+    explicit executor(database& db, dispatcher dispatch = dispatcher());
+
+    // Runs the jobs that are already posted, then stops.
+    ~executor();
+
+    // The future gets what f(db) returns, or what it throws.
+    template <class F>
+    auto post(F f) -> std::future<decltype(f(std::declval<database&>()))> {
+      using R = decltype(f(std::declval<database&>()));
+      auto task = std::make_shared<std::packaged_task<R ()>>(std::bind(std::move(f), std::ref(db_)));
+      auto result = task->get_future();
+      enqueue([task] { (*task)(); });
+      return result;
+    }
+
+    // The statement running now fails with SQLITE_INTERRUPT. Jobs that are
+    // still queued run as usual.
+    void interrupt();
+
+    void stop();
+
+#ifdef SQLITE3PP_HAS_COROUTINES
+    // f is kept as it is, so it can be move-only.
+    template <class F>
+    auto run(F f) -> awaitable<decltype(f(std::declval<database&>())), F> {
+      return awaitable<decltype(f(std::declval<database&>())), F>(this, std::move(f));
+    }
+
+    awaitable<int> execute(std::string sql);
+
+    // cmd has to stay alive until the result is back. It is reset after
+    // it runs.
+    awaitable<int> execute(command& cmd);
+    awaitable<int> commit(transaction& xct);
+#endif
+
+   private:
+    // Throws database_error once the executor has stopped.
+    void enqueue(std::function<void ()> job);
+    void resume(std::function<void ()> r);
+    void loop();
+
+   private:
+    database& db_;
+    dispatcher dispatch_;
+    std::deque<std::function<void ()>> queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+    std::thread thread_;
+  };
+
+#ifdef SQLITE3PP_HAS_COROUTINES
+  template <class R>
+  struct awaitable_result
+  {
+    template <class G>
+    void set(G& f, database& db) {
+      value.emplace(f(db));
+    }
+    R get() {
+      return std::move(*value);
+    }
+
+    std::optional<R> value;
+  };
+
+  template <>
+  struct awaitable_result<void>
+  {
+    template <class G>
+    void set(G& f, database& db) {
+      f(db);
+    }
+    void get() {}
+  };
+
+  // The result of a job run by an executor, for co_await.
+  template <class R, class F>
+  class awaitable
+  {
+    friend class executor;
+
+   public:
+    bool await_ready() const noexcept {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h) {
+      ex_->enqueue([this, h] {
+        try {
+          result_.set(f_, ex_->db_);
+        }
+        catch (...) {
+          error_ = std::current_exception();
+        }
+        ex_->resume([h] { h.resume(); });
+      });
+    }
+
+    R await_resume() {
+      if (error_)
+        std::rethrow_exception(error_);
+      return result_.get();
+    }
+
+   private:
+    awaitable(executor* ex, F f) : ex_(ex), f_(std::move(f)) {}
+
+   private:
+    executor* ex_;
+    F f_;
+    awaitable_result<R> result_;
+    std::exception_ptr error_;
+  };
+
+  // Reads the rows of a query in batches on an executor.
+  //   while (co_await reader.next()) use(reader.batch());
+  // The batch must only be read between the awaits.
+  class batch_reader : noncopyable
+  {
+   public:
+    explicit batch_reader(executor& ex, query& qry, std::size_t rows = 1024);
+
+    // Gets false once the rows are done.
+    awaitable<bool> next();
+
+    column_batch const& batch() const;
+
+   private:
+    executor& ex_;
+    query& qry_;
+    std::size_t rows_;
+    column_batch batch_;
+  };
+#endif
+
+} // namespace sqlite3pp
+
+#endif
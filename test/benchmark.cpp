@@ -0,0 +1,419 @@
+// Times the hot paths of sqlite3pp against the same work done through the
+// sqlite3 C API, and prints the results as JSON.
+//
+// Build it once against each tree, e.g.
+//   g++ -std=c++11 -O2 -I../headeronly_src -DSQLITE3PP_BENCH_TREE='"headeronly_src"' benchmark.cpp -lsqlite3
+//   g++ -std=c++11 -O2 -I../src -DSQLITE3PP_BENCH_TREE='"src"' benchmark.cpp ../src/*.cpp -lsqlite3 -pthread
+// and run with [--rows N] [--reps R] [--filter name].
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "sqlite3pp.h"
+#include "sqlite3ppext.h"
+
+#ifndef SQLITE3PP_BENCH_TREE
+#define SQLITE3PP_BENCH_TREE "sqlite3pp"
+#endif
+
+using namespace std;
+
+namespace
+{
+  int nrows = 100000;
+  int nreps = 5;
+  char const* filter = nullptr;
+
+  struct result
+  {
+    string name;
+    string impl;
+    long long int ops;
+    vector<double> ns;
+  };
+
+  vector<result> results;
+
+  char const* const schema = "CREATE TABLE t (id INTEGER PRIMARY KEY, n INTEGER, x REAL, s TEXT, u TEXT)";
+
+  template <class Db>
+  void record(char const* name, char const* impl, long long int ops, function<Db ()> open,
+              function<void (Db&)> setup, function<void (Db&)> body)
+  {
+    if (filter && !strstr(name, filter))
+      return;
+
+    result r{name, impl, ops, {}};
+    for (int i = 0; i < nreps; ++i) {
+      auto db = open();
+      if (setup)
+        setup(db);
+
+      auto t0 = chrono::steady_clock::now();
+      body(db);
+      auto t1 = chrono::steady_clock::now();
+      r.ns.push_back(chrono::duration<double, nano>(t1 - t0).count() / ops);
+    }
+    results.push_back(r);
+  }
+
+  // setup runs before each repetition and isn't timed. body does ops
+  // operations on a fresh in-memory database.
+  void run(char const* name, char const* impl, long long int ops, function<void (sqlite3pp::database&)> setup,
+           function<void (sqlite3pp::database&)> body)
+  {
+    record<sqlite3pp::database>(name, impl, ops, [] {
+      sqlite3pp::database db(":memory:");
+      db.execute(schema);
+      return db;
+    }, setup, body);
+  }
+
+  // The same through the C API, as the baseline.
+  struct raw
+  {
+    raw() : db(nullptr) {
+      sqlite3_open(":memory:", &db);
+      sqlite3_exec(db, schema, 0, 0, 0);
+    }
+    raw(raw&& r) : db(r.db) {
+      r.db = nullptr;
+    }
+    ~raw() {
+      sqlite3_close(db);
+    }
+    sqlite3* db;
+  };
+
+  void run_c(char const* name, long long int ops, function<void (raw&)> setup, function<void (raw&)> body)
+  {
+    record<raw>(name, "c", ops, [] { return raw(); }, setup, body);
+  }
+
+  string text(int i)
+  {
+    return "some text value number " + to_string(i);
+  }
+
+  void fill_db(sqlite3pp::database& db)
+  {
+    sqlite3pp::transaction xct(db);
+    sqlite3pp::command cmd(db, "INSERT INTO t (n, x, s, u) VALUES (?, ?, ?, ?)");
+    for (int i = 0; i < nrows; ++i) {
+      auto s = text(i);
+      cmd.bind(1, i);
+      cmd.bind(2, i * 0.5);
+      cmd.bind(3, s, sqlite3pp::copy);
+      cmd.bind(4, s, sqlite3pp::copy);
+      cmd.execute();
+      cmd.reset();
+    }
+    xct.commit();
+  }
+
+  void fill_c(raw& r)
+  {
+    sqlite3_exec(r.db, "BEGIN", 0, 0, 0);
+    sqlite3_stmt* stmt;
+    sqlite3_prepare_v2(r.db, "INSERT INTO t (n, x, s, u) VALUES (?, ?, ?, ?)", -1, &stmt, nullptr);
+    for (int i = 0; i < nrows; ++i) {
+      auto s = text(i);
+      sqlite3_bind_int(stmt, 1, i);
+      sqlite3_bind_double(stmt, 2, i * 0.5);
+      sqlite3_bind_text(stmt, 3, s.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_text(stmt, 4, s.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_step(stmt);
+      sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_exec(r.db, "COMMIT", 0, 0, 0);
+  }
+
+  void mul_c(sqlite3_context* ctx, int, sqlite3_value** values)
+  {
+    sqlite3_result_int64(ctx, sqlite3_value_int64(values[0]) * sqlite3_value_int64(values[1]));
+  }
+
+  long long int mul(long long int a, long long int b)
+  {
+    return a * b;
+  }
+
+  struct intsum
+  {
+    void step(long long int n) {
+      n_ += n;
+    }
+    long long int finish() {
+      return n_;
+    }
+    long long int n_ = 0;
+  };
+
+  volatile long long int sink;
+}
+
+int main(int argc, char* argv[])
+{
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--rows")) nrows = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "--reps")) nreps = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "--filter")) filter = argv[i + 1];
+  }
+  if (nreps < 1) {
+    cerr << "--reps must be at least 1" << endl;
+    return 1;
+  }
+
+  try {
+    int const nsingle = std::max(1, nrows / 10);
+
+    run("insert_single", "sqlite3pp", nsingle, nullptr, [&](sqlite3pp::database& db) {
+      for (int i = 0; i < nsingle; ++i) {
+        sqlite3pp::transaction xct(db, false, true);
+        sqlite3pp::command cmd(db, "INSERT INTO t (n, x) VALUES (?, ?)");
+        cmd.binder() << i << i * 0.5;
+        cmd.execute();
+        xct.commit();
+      }
+    });
+
+    run("insert_single", "sqlite3pp_cached", nsingle, [](sqlite3pp::database& db) {
+      db.stmt_cache().set_capacity(8);
+    }, [&](sqlite3pp::database& db) {
+      for (int i = 0; i < nsingle; ++i) {
+        sqlite3pp::transaction xct(db, false, true);
+        sqlite3pp::command cmd(db, "INSERT INTO t (n, x) VALUES (?, ?)");
+        cmd.binder() << i << i * 0.5;
+        cmd.execute();
+        xct.commit();
+      }
+    });
+
+    run_c("insert_single", nsingle, nullptr, [&](raw& r) {
+      for (int i = 0; i < nsingle; ++i) {
+        sqlite3_exec(r.db, "BEGIN IMMEDIATE", 0, 0, 0);
+        sqlite3_stmt* stmt;
+        sqlite3_prepare_v2(r.db, "INSERT INTO t (n, x) VALUES (?, ?)", -1, &stmt, nullptr);
+        sqlite3_bind_int(stmt, 1, i);
+        sqlite3_bind_double(stmt, 2, i * 0.5);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        sqlite3_exec(r.db, "COMMIT", 0, 0, 0);
+      }
+    });
+
+    run("insert_batched", "sqlite3pp", nrows, nullptr, [&](sqlite3pp::database& db) {
+      sqlite3pp::transaction xct(db);
+      sqlite3pp::command cmd(db, "INSERT INTO t (n, x, s) VALUES (?, ?, ?)");
+      for (int i = 0; i < nrows; ++i) {
+        cmd.binder() << i << i * 0.5 << sqlite3pp::nocopy << "some text value";
+        cmd.execute();
+        cmd.reset();
+      }
+      xct.commit();
+    });
+
+    run("insert_batched", "bulk_inserter", nrows, nullptr, [&](sqlite3pp::database& db) {
+      sqlite3pp::command cmd(db, "INSERT INTO t (n, x, s) VALUES (?, ?, ?)");
+      sqlite3pp::bulk_inserter ins(cmd);
+      for (int i = 0; i < nrows; ++i) {
+        ins.insert(i, i * 0.5, "some text value");
+      }
+      ins.finish();
+    });
+
+    run_c("insert_batched", nrows, nullptr, [&](raw& r) {
+      sqlite3_exec(r.db, "BEGIN", 0, 0, 0);
+      sqlite3_stmt* stmt;
+      sqlite3_prepare_v2(r.db, "INSERT INTO t (n, x, s) VALUES (?, ?, ?)", -1, &stmt, nullptr);
+      for (int i = 0; i < nrows; ++i) {
+        sqlite3_bind_int(stmt, 1, i);
+        sqlite3_bind_double(stmt, 2, i * 0.5);
+        sqlite3_bind_text(stmt, 3, "some text value", -1, SQLITE_STATIC);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+      }
+      sqlite3_finalize(stmt);
+      sqlite3_exec(r.db, "COMMIT", 0, 0, 0);
+    });
+
+    run("bind_positional", "sqlite3pp", nrows, nullptr, [&](sqlite3pp::database& db) {
+      sqlite3pp::command cmd(db, "SELECT ?1, ?2, ?3");
+      for (int i = 0; i < nrows; ++i) {
+        cmd.bind(1, i);
+        cmd.bind(2, i * 0.5);
+        cmd.bind(3, "some text value", sqlite3pp::nocopy);
+        cmd.reset();
+      }
+    });
+
+    run("bind_named", "sqlite3pp", nrows, nullptr, [&](sqlite3pp::database& db) {
+      sqlite3pp::command cmd(db, "SELECT :n, :x, :s");
+      for (int i = 0; i < nrows; ++i) {
+        cmd.bind(":n", i);
+        cmd.bind(":x", i * 0.5);
+        cmd.bind(":s", "some text value", sqlite3pp::nocopy);
+        cmd.reset();
+      }
+    });
+
+    run_c("bind_positional", nrows, nullptr, [&](raw& r) {
+      sqlite3_stmt* stmt;
+      sqlite3_prepare_v2(r.db, "SELECT ?1, ?2, ?3", -1, &stmt, nullptr);
+      for (int i = 0; i < nrows; ++i) {
+        sqlite3_bind_int(stmt, 1, i);
+        sqlite3_bind_double(stmt, 2, i * 0.5);
+        sqlite3_bind_text(stmt, 3, "some text value", -1, SQLITE_STATIC);
+        sqlite3_reset(stmt);
+      }
+      sqlite3_finalize(stmt);
+    });
+
+    run("select_numeric", "sqlite3pp", nrows, fill_db, [&](sqlite3pp::database& db) {
+      sqlite3pp::query qry(db, "SELECT id, n, x FROM t");
+      long long int sum = 0;
+      for (auto v : qry) {
+        sum += v.get<long long int>(0) + v.get<int>(1) + static_cast<long long int>(v.get<double>(2));
+      }
+      sink = sum;
+    });
+
+    run("select_numeric", "fetch_batch", nrows, fill_db, [&](sqlite3pp::database& db) {
+      sqlite3pp::query qry(db, "SELECT id, n, x FROM t");
+      sqlite3pp::column_batch batch;
+      long long int sum = 0;
+      while (auto n = qry.fetch_batch(batch, 1024)) {
+        for (size_t i = 0; i < n; ++i) {
+          sum += batch[0].ints[i] + batch[1].ints[i] + static_cast<long long int>(batch[2].reals[i]);
+        }
+      }
+      sink = sum;
+    });
+
+    run_c("select_numeric", nrows, fill_c, [&](raw& r) {
+      sqlite3_stmt* stmt;
+      sqlite3_prepare_v2(r.db, "SELECT id, n, x FROM t", -1, &stmt, nullptr);
+      long long int sum = 0;
+      while (sqlite3_step(stmt) == SQLITE_ROW) {
+        sum += sqlite3_column_int64(stmt, 0) + sqlite3_column_int(stmt, 1) + static_cast<long long int>(sqlite3_column_double(stmt, 2));
+      }
+      sqlite3_finalize(stmt);
+      sink = sum;
+    });
+
+    run("select_text", "sqlite3pp", nrows, fill_db, [&](sqlite3pp::database& db) {
+      sqlite3pp::query qry(db, "SELECT s, u FROM t");
+      size_t len = 0;
+      for (auto v : qry) {
+        len += v.get<string>(0).size() + v.get<string>(1).size();
+      }
+      sink = static_cast<long long int>(len);
+    });
+
+    run("select_text", "sqlite3pp_view", nrows, fill_db, [&](sqlite3pp::database& db) {
+      sqlite3pp::query qry(db, "SELECT s, u FROM t");
+      size_t len = 0;
+      for (auto v : qry) {
+        len += static_cast<size_t>(v.get<sqlite3pp::blob_view>(0).size + v.get<sqlite3pp::blob_view>(1).size);
+      }
+      sink = static_cast<long long int>(len);
+    });
+
+    run_c("select_text", nrows, fill_c, [&](raw& r) {
+      sqlite3_stmt* stmt;
+      sqlite3_prepare_v2(r.db, "SELECT s, u FROM t", -1, &stmt, nullptr);
+      size_t len = 0;
+      while (sqlite3_step(stmt) == SQLITE_ROW) {
+        sqlite3_column_text(stmt, 0);
+        sqlite3_column_text(stmt, 1);
+        len += static_cast<size_t>(sqlite3_column_bytes(stmt, 0) + sqlite3_column_bytes(stmt, 1));
+      }
+      sqlite3_finalize(stmt);
+      sink = static_cast<long long int>(len);
+    });
+
+    run("select_by_name", "sqlite3pp", nrows, fill_db, [&](sqlite3pp::database& db) {
+      sqlite3pp::query qry(db, "SELECT id, n, x FROM t");
+      long long int sum = 0;
+      for (auto v : qry) {
+        sum += v.get<long long int>("id") + v.get<int>("n");
+      }
+      sink = sum;
+    });
+
+    run("execute_all", "sqlite3pp", nrows, nullptr, [&](sqlite3pp::database& db) {
+      sqlite3pp::transaction xct(db);
+      sqlite3pp::command cmd(db, "INSERT INTO t (n) VALUES (:n); INSERT INTO t (x) VALUES (:n)");
+      for (int i = 0; i < nrows; i += 2) {
+        cmd.bind(":n", i);
+        cmd.execute_all();
+        cmd.reset();
+      }
+      xct.commit();
+    });
+
+    run("udf", "std_function", nrows, fill_db, [&](sqlite3pp::database& db) {
+      sqlite3pp::ext::function func(db);
+      func.create<long long int (long long int, long long int)>("f", &mul);
+      sqlite3pp::query qry(db, "SELECT sum(f(n, 2)) FROM t");
+      sink = (*qry.begin()).get<long long int>(0);
+    });
+
+    run("udf", "direct", nrows, fill_db, [&](sqlite3pp::database& db) {
+      sqlite3pp::ext::function func(db);
+      func.create<decltype(&mul), &mul>("f");
+      sqlite3pp::query qry(db, "SELECT sum(f(n, 2)) FROM t");
+      sink = (*qry.begin()).get<long long int>(0);
+    });
+
+    run("udf", "builtin", nrows, fill_db, [&](sqlite3pp::database& db) {
+      sqlite3pp::query qry(db, "SELECT sum(n * 2) FROM t");
+      sink = (*qry.begin()).get<long long int>(0);
+    });
+
+    run_c("udf", nrows, fill_c, [&](raw& r) {
+      sqlite3_create_function(r.db, "f", 2, SQLITE_UTF8, nullptr, mul_c, 0, 0);
+      sqlite3_stmt* stmt;
+      sqlite3_prepare_v2(r.db, "SELECT sum(f(n, 2)) FROM t", -1, &stmt, nullptr);
+      sqlite3_step(stmt);
+      sink = sqlite3_column_int64(stmt, 0);
+      sqlite3_finalize(stmt);
+    });
+
+    run("aggregate", "sqlite3pp", nrows, fill_db, [&](sqlite3pp::database& db) {
+      sqlite3pp::ext::aggregate aggr(db);
+      aggr.create<intsum, long long int>("s");
+      sqlite3pp::query qry(db, "SELECT s(n) FROM t");
+      sink = (*qry.begin()).get<long long int>(0);
+    });
+
+    run("aggregate", "builtin", nrows, fill_db, [&](sqlite3pp::database& db) {
+      sqlite3pp::query qry(db, "SELECT sum(n) FROM t");
+      sink = (*qry.begin()).get<long long int>(0);
+    });
+  }
+  catch (exception& ex) {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+
+  cout << "{\"tree\": \"" << SQLITE3PP_BENCH_TREE << "\", \"sqlite_version\": \"" << sqlite3_libversion()
+       << "\", \"rows\": " << nrows << ", \"reps\": " << nreps << ", \"results\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    auto& r = results[i];
+    auto ns = r.ns;
+    sort(ns.begin(), ns.end());
+    double mean = 0;
+    for (auto n : ns) mean += n / ns.size();
+    cout << (i ? ",\n  " : "\n  ") << "{\"name\": \"" << r.name << "\", \"impl\": \"" << r.impl << "\", \"ops\": " << r.ops
+         << ", \"ns_per_op_min\": " << ns.front() << ", \"ns_per_op_median\": " << ns[ns.size() / 2]
+         << ", \"ns_per_op_mean\": " << mean << "}";
+  }
+  cout << "\n]}" << endl;
+}
@@ -83,6 +83,59 @@ struct plussum
   int n_;
 };
 
+struct movsum
+{
+  void step(int n) {
+    n_ += n;
+  }
+  void inverse(int n) {
+    n_ -= n;
+  }
+  int value() {
+    return n_;
+  }
+  int finish() {
+    return n_;
+  }
+  int n_;
+};
+
+struct movcat
+{
+  void step(string const& s) {
+    s_ += s;
+  }
+  void inverse(string const& s) {
+    s_.erase(0, s.size());
+  }
+  string value() {
+    return s_;
+  }
+  string finish() {
+    return s_;
+  }
+  string s_;
+};
+
+struct alignas(64) wide
+{
+  wide() = default;
+  wide(wide const&) = delete;
+  wide& operator=(wide const&) = delete;
+
+  void step(double d) {
+    lanes_[n_++ % 8] += d;
+  }
+  double finish() {
+    if (reinterpret_cast<std::size_t>(this) % 64 != 0) return -1;
+    double sum = 0;
+    for (auto l : lanes_) sum += l;
+    return sum;
+  }
+  double lanes_[8];
+  int n_;
+};
+
 int main()
 {
   try {
@@ -111,6 +164,26 @@ int main()
       cout << endl;
     }
     cout << endl;
+
+    cout << aggr.create<movsum, int>("w0") << endl;
+    cout << aggr.create<movcat, string>("w1") << endl;
+
+    cout << aggr.create<wide, double>("a7") << endl;
+
+    sqlite3pp::query eqry(db, "SELECT a3(id), a4(), a5(name), a7(id) FROM foods WHERE id < 0");
+    for (auto v : eqry) {
+      cout << v.get<int>(0) << "\t" << v.get<int>(1) << "\t" << v.get<int>(2) << "\t" << v.get<double>(3) << endl;
+    }
+    sqlite3pp::query aqry(db, "SELECT a7(id), sum(id) FROM foods");
+    for (auto v : aqry) {
+      cout << v.get<double>(0) << "\t" << v.get<double>(1) << endl;
+    }
+
+    sqlite3pp::query wqry(db, "SELECT id, w0(id) OVER w, w1(name) OVER w FROM foods WHERE id <= 5 "
+                              "WINDOW w AS (ORDER BY id ROWS BETWEEN 1 PRECEDING AND CURRENT ROW)");
+    for (auto v : wqry) {
+      cout << v.get<int>(0) << "\t" << v.get<int>(1) << "\t" << v.get<char const*>(2) << endl;
+    }
   }
   catch (exception& ex) {
     cout << ex.what() << endl;
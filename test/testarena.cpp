@@ -0,0 +1,54 @@
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "sqlite3pp.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+
+    {
+      sqlite3pp::transaction xct(db);
+      sqlite3pp::command cmd(db, "INSERT INTO contacts (name, phone) VALUES (?, ?)");
+      for (int i = 0; i < 10000; ++i) {
+        cmd.binder() << "name" + to_string(i) << "555-" + to_string(i);
+        cmd.execute();
+        cmd.reset();
+      }
+      xct.commit();
+    }
+
+    sqlite3pp::arena a(256 * 1024);
+    sqlite3pp::query qry(db, "SELECT id, name, phone FROM contacts");
+    qry.set_arena(&a);
+
+    // The pointers stay valid after the query moves on.
+    vector<tuple<int, char const*, sqlite3pp::blob_view>> rows;
+    for (auto v : qry) {
+      rows.push_back(v.get_columns<int, char const*, sqlite3pp::blob_view>(0, 1, 2));
+    }
+    cout << rows.size() << "\t" << get<1>(rows[1]) << "\t" << get<1>(rows.back()) << "\t"
+         << string(static_cast<char const*>(get<2>(rows.back()).data), get<2>(rows.back()).size) << endl;
+    cout << "used: " << a.used() << ", blocks of 256k: " << a.capacity() / (256 * 1024) << endl;
+
+    // Reused for the next pass without allocating.
+    auto capacity = a.capacity();
+    a.reset();
+    qry.reset();
+    size_t n = 0;
+    for (auto const& c : qry.as<int, char const*>()) {
+      n += std::get<1>(c) != nullptr;
+    }
+    cout << n << "\t" << (a.capacity() == capacity) << endl;
+
+    qry.set_arena(nullptr);
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include "sqlite3pp.h"
+#include "sqlite3ppthread.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+
+    {
+      sqlite3pp::transaction xct(db);
+      sqlite3pp::command cmd(db, "INSERT INTO contacts (name, phone) VALUES (?, ?)");
+      for (int i = 0; i < 20000; ++i) {
+        cmd.binder() << "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAA" << "1234";
+        cmd.execute();
+        cmd.reset();
+      }
+      xct.commit();
+    }
+
+    {
+      // Driven step by step, as an event loop would.
+      sqlite3pp::database backupdb("backup.db");
+      sqlite3pp::backup_options opts;
+      opts.step_page = 4;
+      sqlite3pp::backup_job job(db, backupdb, {}, opts);
+
+      int rc, nsteps = 0;
+      while ((rc = job.step()) == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+        ++nsteps;
+        sqlite3_sleep(static_cast<int>(job.delay().count()));
+      }
+      cout << "rc: " << rc << ", steps: " << nsteps << ", step_page: " << job.step_page() << endl;
+    }
+
+    {
+      // Throttled to 2000 pages a second on a background thread.
+      sqlite3pp::database backupdb("backup.db");
+      sqlite3pp::backup_options opts;
+      opts.step_page = 10;
+      opts.step_time = std::chrono::milliseconds(0);
+      opts.max_pages_per_sec = 2000;
+      sqlite3pp::backup_job job(db, backupdb, [](int remaining, int pagecount, int rc) {
+        cout << remaining << "/" << pagecount << " " << rc << endl;
+      }, opts);
+
+      sqlite3pp::backup_thread t(job);
+      cout << "rc: " << t.wait() << endl;
+    }
+
+    {
+      sqlite3pp::database backupdb("backup.db");
+      sqlite3pp::backup_options opts;
+      opts.step_page = 1;
+      opts.step_time = std::chrono::milliseconds(0);
+      opts.max_pages_per_sec = 10;
+      sqlite3pp::backup_job job(db, backupdb, {}, opts);
+
+      sqlite3pp::backup_thread t(job);
+      sqlite3_sleep(200);
+      t.cancel();
+      cout << "cancelled rc: " << t.wait() << endl;
+    }
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
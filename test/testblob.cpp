@@ -0,0 +1,74 @@
+#include <iostream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include "sqlite3pp.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+
+    db.execute("CREATE TEMP TABLE files (id INTEGER PRIMARY KEY, data BLOB)");
+
+    {
+      sqlite3pp::command cmd(db, "INSERT INTO files (data) VALUES (?)");
+      cout << cmd.bind_zeroblob(1, 1000000) << endl;
+      cout << cmd.execute() << endl;
+    }
+    auto rowid = db.last_insert_rowid();
+
+    {
+      sqlite3pp::blob b(db, "files", "data", rowid, true, "temp");
+      cout << "size: " << b.size() << endl;
+
+      string chunk(1000, 'a');
+      for (int off = 0; off < b.size(); off += 1000) {
+        chunk[0] = static_cast<char>('0' + off / 1000 % 10);
+        b.write(chunk.data(), static_cast<int>(chunk.size()), off);
+      }
+
+      char head[4] = {};
+      cout << b.read(head, 3, 999000) << "\t" << head << endl;
+    }
+
+    {
+      sqlite3pp::blob b(db, "files", "data", rowid, true, "temp");
+      sqlite3pp::blobbuf buf(b, 4096);
+      std::ostream os(&buf);
+      os.seekp(500);
+      os << "hello";
+      os.flush();
+      // Writing past the end fails.
+      os.seekp(b.size() - 2);
+      os << "xyz";
+      os.flush();
+      cout << "overrun: " << (os.fail() ? "failed" : "ok") << endl;
+    }
+
+    {
+      sqlite3pp::blob b(db, "files", "data", rowid, false, "temp");
+      sqlite3pp::blobbuf buf(b, 4096);
+      std::istream is(&buf);
+      is.seekg(500);
+      string s(5, '\0');
+      is.read(&s[0], 5);
+      cout << s << endl;
+
+      is.seekg(0);
+      size_t n = 0, digits = 0;
+      char c;
+      while (is.get(c)) {
+        if (c >= '0' && c <= '9') ++digits;
+        ++n;
+      }
+      cout << "read: " << n << ", digits: " << digits << endl;
+    }
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
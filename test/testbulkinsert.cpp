@@ -0,0 +1,79 @@
+#include <cstddef>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <iostream>
+#include "sqlite3pp.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+
+    sqlite3pp::command cmd(db, "INSERT INTO contacts (name, phone) VALUES (?, ?)");
+
+    {
+      sqlite3pp::bulk_inserter ins(cmd, 1000, 0, true);
+
+      for (int i = 0; i < 10000; ++i) {
+        ins.insert(std::to_string(i), "1234");
+      }
+
+      vector<tuple<string, string>> rows;
+      rows.emplace_back("AAAA", "5678");
+      rows.emplace_back("BBBB", "9012");
+      ins.insert_all(rows);
+
+      ins.insert(std::make_tuple("CCCC", std::string("7890")));
+
+      cout << ins.finish() << endl;
+      cout << ins.rows() << " rows, " << ins.bytes() << " bytes, " << ins.rows_per_sec() << " rows/sec" << endl;
+    }
+
+    {
+      // The rows go into the caller's transaction.
+      sqlite3pp::transaction xct(db);
+      sqlite3pp::bulk_inserter ins(cmd, 10);
+      for (int i = 0; i < 100; ++i) {
+        ins.insert("DDDD", "3456");
+      }
+      cout << ins.finish() << endl;
+    }
+
+    try {
+      // The rows of the batch cut short are rolled back.
+      sqlite3pp::bulk_inserter ins(cmd, 10);
+      ins.insert("EEEE", "3456");
+      ins.insert("FFFF", sqlite3pp::ignore);
+    }
+    catch (exception& ex) {
+      cout << ex.what() << endl;
+    }
+
+    {
+      // A failed row leaves the command ready for the next one.
+      auto id = db.query_one<long long int>("SELECT max(id) + 1 FROM contacts");
+      sqlite3pp::command cmd2(db, "INSERT INTO contacts (id, name, phone) VALUES (?, ?, ?)");
+      sqlite3pp::bulk_inserter ins(cmd2, 10);
+      ins.insert(id, "GGGG", "3456");
+      try {
+        ins.insert(id, "HHHH", "3456");
+      }
+      catch (exception& ex) {
+        cout << ex.what() << endl;
+      }
+      ins.insert(std::size_t(id + 1), "IIII", true);
+      cout << ins.finish() << endl;
+      cout << db.query_one<int>("SELECT count(*) FROM contacts WHERE id > ?", id - 1) << endl;
+    }
+
+    sqlite3pp::query qry(db, "SELECT count(*) FROM contacts");
+    cout << (*qry.begin()).get<int>(0) << endl;
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
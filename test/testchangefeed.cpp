@@ -0,0 +1,75 @@
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sqlite3ppthread.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+
+    std::mutex m;
+    std::vector<std::string> batches;
+
+    {
+      sqlite3pp::change_feed feed(db, [&](std::vector<sqlite3pp::change_feed::change> const& changes) {
+        // The names only live as long as the feed.
+        std::ostringstream os;
+        for (auto const& c : changes) {
+          os << c.op << " " << c.dbname << "." << c.table << " " << c.rowid << "\t";
+        }
+        std::lock_guard<std::mutex> lock(m);
+        batches.push_back(os.str());
+      }, 4);
+
+      {
+        sqlite3pp::transaction xct(db);
+        db.execute("INSERT INTO contacts (name, phone) VALUES ('AAAA', '1234')");
+        db.execute("UPDATE contacts SET phone = '5678' WHERE name = 'AAAA'");
+        xct.commit();
+      }
+
+      {
+        // Rolled back, so the consumer never sees it.
+        sqlite3pp::transaction xct(db);
+        db.execute("INSERT INTO contacts (name, phone) VALUES ('BBBB', '1234')");
+        xct.rollback();
+      }
+
+      for (int i = 0; i < 20; ++i) {
+        db.execute("DELETE FROM contacts WHERE name = 'AAAA'");
+        db.execute("INSERT INTO contacts (name, phone) VALUES ('AAAA', '1234')");
+      }
+
+      // The destructor waits for the committed batches.
+      cout << "batches: " << feed.batches() << ", changes: " << feed.changes() << endl;
+    }
+
+    for (auto const& b : batches) {
+      cout << b << endl;
+    }
+
+    {
+      // A slow consumer makes the writer sleep until a slot is free.
+      size_t n = 0;
+      sqlite3pp::change_feed feed(db, [&](std::vector<sqlite3pp::change_feed::change> const& changes) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        n += changes.size();
+      }, 1);
+      for (int i = 0; i < 20; ++i) {
+        db.execute("INSERT INTO contacts (name, phone) VALUES ('CCCC', '1234')");
+      }
+      cout << "stalled: " << (feed.stalls() > 0) << ", changes: " << feed.changes() << endl;
+    }
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
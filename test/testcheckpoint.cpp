@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include "sqlite3pp.h"
+#include "sqlite3ppthread.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    remove("checkpoint.db");
+    remove("checkpoint.db-wal");
+    remove("checkpoint.db-shm");
+
+    sqlite3pp::database::options opts;
+    opts.journal_mode = "wal";
+    sqlite3pp::database db("checkpoint.db", opts);
+    db.execute("CREATE TABLE log (id INTEGER PRIMARY KEY, msg TEXT NOT NULL)");
+
+    sqlite3pp::busy_backoff backoff;
+    db.set_busy_handler(std::ref(backoff));
+
+    {
+      sqlite3pp::checkpoint_scheduler::options copts;
+      copts.passive_pages = 20;
+      copts.restart_pages = 50;
+      copts.truncate_pages = 100;
+      copts.interval = chrono::milliseconds(10);
+      sqlite3pp::checkpoint_scheduler scheduler(db, copts);
+
+      // A reader holds on to the WAL, so the checkpoints can't finish
+      // until it's done.
+      sqlite3pp::database reader("checkpoint.db");
+      reader.execute("BEGIN");
+      reader.query_one<int>("SELECT count(*) FROM log");
+
+      for (int i = 0; i < 2000; ++i) {
+        db.execute("INSERT INTO log (msg) VALUES (?)", string(1000, 'a' + i % 26));
+        if (i == 1000)
+          reader.execute("COMMIT");
+      }
+
+      for (int i = 0; i < 500 && scheduler.truncates() == 0; ++i) {
+        this_thread::sleep_for(chrono::milliseconds(10));
+      }
+      cout << "checkpoints: " << (scheduler.checkpoints() > 0) << ", busy: " << (scheduler.busy() > 0)
+           << ", truncates: " << (scheduler.truncates() > 0) << endl;
+    }
+
+    // SQLite checkpoints on its own again.
+    cout << "wal_autocheckpoint: " << db.tune().wal_autocheckpoint << endl;
+
+    // A writer holds the lock for a while, and the handler waits it out.
+    sqlite3pp::database other("checkpoint.db");
+    other.execute("BEGIN IMMEDIATE");
+    thread t([&] {
+      this_thread::sleep_for(chrono::milliseconds(50));
+      other.execute("COMMIT");
+    });
+    cout << db.execute("INSERT INTO log (msg) VALUES ('waited')") << endl;
+    t.join();
+    cout << "contentions: " << (backoff.contentions() > 0) << ", retries: " << (backoff.retries() > 0)
+         << ", timeouts: " << backoff.timeouts() << endl;
+
+    sqlite3pp::busy_backoff impatient(chrono::microseconds(100), chrono::milliseconds(2), chrono::milliseconds(10));
+    db.set_busy_handler(std::ref(impatient));
+    other.execute("BEGIN IMMEDIATE");
+    cout << db.execute("INSERT INTO log (msg) VALUES ('given up')") << endl;
+    other.execute("COMMIT");
+    cout << "timeouts: " << impatient.timeouts() << endl;
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
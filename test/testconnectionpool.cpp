@@ -0,0 +1,52 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "sqlite3pp.h"
+#include "sqlite3ppthread.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    sqlite3pp::connection_pool pool("pool.db", 4);
+
+    {
+      auto w = pool.writer();
+      w->execute("CREATE TABLE IF NOT EXISTS items (id INTEGER PRIMARY KEY, name TEXT)");
+      sqlite3pp::command cmd(*w, "INSERT INTO items (name) VALUES (?)");
+      sqlite3pp::bulk_inserter ins(cmd);
+      for (int i = 0; i < 1000; ++i) {
+        ins.insert("item");
+      }
+      ins.finish();
+    }
+
+    vector<thread> readers;
+    vector<int> counts(8);
+    for (int t = 0; t < 8; ++t) {
+      readers.emplace_back([&pool, &counts, t] {
+        for (int i = 0; i < 100; ++i) {
+          auto r = pool.reader();
+          sqlite3pp::query qry(*r, "SELECT count(*) FROM items");
+          counts[t] = (*qry.begin()).get<int>(0);
+        }
+      });
+    }
+    for (auto& t : readers) {
+      t.join();
+    }
+
+    for (auto c : counts) {
+      cout << c << "\t";
+    }
+    cout << endl;
+
+    auto r = pool.reader();
+    cout << pool.readers() << "\t" << r->stmt_cache().hits() << endl;
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
@@ -0,0 +1,45 @@
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include "sqlite3pp.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+    db.stmt_cache().set_capacity(8);
+
+    {
+      sqlite3pp::transaction xct(db);
+
+      for (int i = 0; i < 5; ++i) {
+        cout << db.execute("INSERT INTO contacts (name, phone) VALUES (?, ?)", "AAAA", std::to_string(1000 + i)) << endl;
+      }
+      cout << db.execute("UPDATE contacts SET phone = ? WHERE name = ? AND phone = ?", 42, "AAAA", "1004") << endl;
+
+      xct.commit();
+    }
+
+    cout << db.query_one<int>("SELECT count(*) FROM contacts WHERE name = ?", "AAAA") << endl;
+    cout << db.query_one<std::string>("SELECT phone FROM contacts WHERE name = ? AND phone > ?", "AAAA", 1002) << endl;
+    cout << db.query_one<long long int>("SELECT count(*) FROM contacts WHERE phone IS NOT ?", sqlite3pp::ignore) << endl;
+
+    // Five inserts shared one statement.
+    auto& sc = db.stmt_cache();
+    cout << "hits: " << sc.hits() << ", misses: " << sc.misses() << endl;
+
+    // Other integer and floating point types bind too.
+    cout << db.query_one<long long int>("SELECT ? + ? + ?", std::int64_t{1} << 40, std::size_t{2}, true) << endl;
+    cout << db.query_one<double>("SELECT ?", 0.5f) << endl;
+
+    cout << db.execute("INSERT INTO nowhere VALUES (?)", 1) << endl;
+
+    db.query_one<int>("SELECT id FROM contacts WHERE name = ?", "ZZZZ");
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
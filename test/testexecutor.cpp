@@ -0,0 +1,95 @@
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include "sqlite3ppthread.h"
+
+using namespace std;
+
+#ifdef SQLITE3PP_HAS_COROUTINES
+// Starts right away and lets main wait for the end.
+struct task
+{
+  struct promise_type
+  {
+    std::promise<void> done;
+
+    task get_return_object() { return task{done.get_future()}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() { done.set_value(); }
+    void unhandled_exception() { done.set_exception(std::current_exception()); }
+  };
+
+  std::future<void> done;
+};
+
+task run(sqlite3pp::executor& ex, sqlite3pp::database& db)
+{
+  cout << co_await ex.execute("INSERT INTO contacts (name, phone) VALUES ('CCCC', '1234')") << endl;
+
+  sqlite3pp::command cmd(db, "INSERT INTO contacts (name, phone) VALUES ('DDDD', '1234')");
+  cout << co_await ex.execute(cmd) << endl;
+
+  auto n = co_await ex.run([](sqlite3pp::database& db) {
+    return db.query_one<int>("SELECT count(*) FROM contacts");
+  });
+  cout << "count: " << n << endl;
+
+  // A job can own what it needs, even if it can only be moved.
+  auto job = [name = std::make_unique<std::string>("DDDD")](sqlite3pp::database& db) {
+    return db.query_one<int>("SELECT count(*) FROM contacts WHERE name = ?", *name);
+  };
+  auto m = co_await ex.run(std::move(job));
+  cout << "count: " << (m > 0) << endl;
+
+  sqlite3pp::query qry(db, "SELECT id, name FROM contacts");
+  sqlite3pp::batch_reader reader(ex, qry, 2);
+  size_t nbatches = 0, nrows = 0;
+  while (co_await reader.next()) {
+    ++nbatches;
+    nrows += reader.batch().size();
+  }
+  cout << "batches: " << (nbatches == (n + 1) / 2) << ", rows: " << (nrows == static_cast<size_t>(n)) << endl;
+}
+#endif
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+
+    {
+      sqlite3pp::executor ex(db);
+
+      auto f = ex.post([](sqlite3pp::database& db) {
+        return db.execute("INSERT INTO contacts (name, phone) VALUES ('AAAA', '1234')");
+      });
+      cout << f.get() << endl;
+
+      auto g = ex.post([](sqlite3pp::database& db) {
+        return db.query_one<int>("SELECT count(*) FROM contacts");
+      });
+      cout << "count: " << g.get() << endl;
+
+      // Runs until it is interrupted.
+      auto h = ex.post([](sqlite3pp::database& db) {
+        return db.execute("WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c) SELECT count(*) FROM c");
+      });
+      while (h.wait_for(std::chrono::milliseconds(50)) != std::future_status::ready) {
+        ex.interrupt();
+      }
+      cout << h.get() << endl;
+
+#ifdef SQLITE3PP_HAS_COROUTINES
+      run(ex, db).done.get();
+#endif
+    }
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
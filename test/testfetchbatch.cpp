@@ -0,0 +1,62 @@
+#include <iostream>
+#include <string>
+#include "sqlite3pp.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+
+    {
+      sqlite3pp::transaction xct(db);
+      sqlite3pp::command cmd(db, "INSERT INTO contacts (name, phone) VALUES (?, ?)");
+      for (int i = 0; i < 25; ++i) {
+        cmd.binder() << "name" + to_string(i) << to_string(i * 1.5);
+        cmd.execute();
+        cmd.reset();
+      }
+      xct.commit();
+    }
+
+    sqlite3pp::query qry(db, "SELECT id, name, CAST(phone AS REAL), CASE WHEN id % 3 = 0 THEN NULL ELSE id END FROM contacts");
+
+    sqlite3pp::column_batch batch;
+    long long int ids = 0;
+    double phones = 0;
+    size_t names = 0, nulls = 0, nbatches = 0;
+    while (auto n = qry.fetch_batch(batch, 10)) {
+      ++nbatches;
+      auto& id = batch[0];
+      auto& name = batch[1];
+      auto& phone = batch[2];
+      auto& maybe = batch[3];
+      for (size_t i = 0; i < n; ++i) {
+        ids += id.ints[i];
+        names += name.length(i);
+        phones += phone.reals[i];
+        if (maybe.is_null(i)) ++nulls;
+      }
+      if (nbatches == 1) {
+        cout << string(name.data(1), name.length(1)) << endl;
+        cout << id.type << "\t" << name.type << "\t" << phone.type << "\t" << maybe.type << endl;
+      }
+    }
+    cout << "batches: " << nbatches << ", ids: " << ids << ", names: " << names << ", phones: " << phones
+         << ", nulls: " << nulls << endl;
+
+    // Re-preparing starts the column types over, even with as many columns.
+    qry.prepare("SELECT 'x', 1 UNION ALL SELECT 'yy', 2");
+    qry.fetch_batch(batch, 10);
+    qry.prepare("SELECT 3, 'zzz'");
+    if (qry.fetch_batch(batch, 10) == 1) {
+      cout << batch[0].type << "\t" << batch[1].type << "\t" << batch[0].ints[0] << "\t"
+           << string(batch[1].data(0), batch[1].length(0)) << endl;
+    }
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
@@ -36,6 +36,18 @@ std::string test6(std::string const& s1, std::string const& s2, std::string cons
   return s1 + s2 + s3;
 }
 
+long long int test7(long long int a, long long int b)
+{
+  return a * b;
+}
+
+struct test8
+{
+  int operator()(sqlite3pp::blob_view b) const {
+    return b.size;
+  }
+};
+
 int main()
 {
   try {
@@ -49,8 +61,16 @@ int main()
     cout << func.create<int ()>("h4", []{return 500;}) << endl;
     cout << func.create<int (int)>("h5", [](int i){return i + 1000;}) << endl;
     cout << func.create<string (string, string, string)>("h6", &test6) << endl;
+    cout << func.create<decltype(&test7), &test7>("h7", SQLITE_DETERMINISTIC) << endl;
+    cout << func.create<test8>("h8", SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS) << endl;
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+    cout << func.create<std::string_view (std::string_view)>("h9", [](std::string_view s) { return s.substr(1); }) << endl;
+    cout << func.create<&test7>("h7", SQLITE_DETERMINISTIC) << endl;
+#else
+    cout << func.create<string (string)>("h9", [](string s) { return s.substr(1); }) << endl;
+#endif
 
-    sqlite3pp::query qry(db, "SELECT h0(), h1(), h2('x'), h3('y'), h4(), h5(10), h6('a', 'b', 'c')");
+    sqlite3pp::query qry(db, "SELECT h0(), h1(), h2('x'), h3('y'), h4(), h5(10), h6('a', 'b', 'c'), h7(6, 7), h8(x'0102'), h9('xyz')");
 
     for (int i = 0; i < qry.column_count(); ++i) {
       cout << qry.column_name(i) << "\t";
@@ -1,3 +1,4 @@
+#include <string>
 #include <iostream>
 #include "sqlite3pp.h"
 
@@ -39,6 +40,29 @@ int main()
 
       cout << cmd.execute() << endl;
     }
+
+    {
+      sqlite3pp::transaction xct(db, true);
+
+      sqlite3pp::command cmd(db, "INSERT INTO contacts (name, phone) VALUES (?, ?)");
+
+      std::string name = "EEEE";
+      cmd.binder() << sqlite3pp::nocopy << name << "1234";
+      cout << cmd.execute() << endl;
+
+      cout << cmd.reset() << endl;
+
+      char const phone[] = "5678 (ignored)";
+      cout << cmd.bind_text(2, phone, 4, sqlite3pp::nocopy) << endl;
+      cout << cmd.execute() << endl;
+
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+      cout << cmd.reset() << endl;
+
+      cmd.binder() << sqlite3pp::nocopy << std::string_view("FFFF") << std::string_view("9012");
+      cout << cmd.execute() << endl;
+#endif
+    }
   }
   catch (exception& ex) {
     cout << ex.what() << endl;
@@ -1,3 +1,4 @@
+#include <string>
 #include <iostream>
 #include "sqlite3pp.h"
 
@@ -19,9 +20,66 @@ int main()
 	  cout << cmd.bind(":name", "user", sqlite3pp::copy) << endl;
 	  cout << cmd.execute_all() << endl;
 	}
+	for (int i = 0; i < 3; ++i) {
+	  // Every statement is kept prepared; the bindings go to all of them.
+	  cout << cmd.reset() << endl;
+	  cout << cmd.bind(":name", "user" + std::to_string(i), sqlite3pp::copy) << endl;
+	  cout << cmd.execute_all() << endl;
+	}
       }
       xct.commit();
     }
+
+    {
+      // :phone only appears after the first statement.
+      sqlite3pp::command cmd(db,
+			     "INSERT INTO contacts (name, phone) VALUES (:name, '3456');"
+			     "UPDATE contacts SET phone = :phone WHERE name = :name;"
+			     );
+      cout << cmd.bind(":name", "user3", sqlite3pp::copy) << endl;
+      cout << cmd.bind(":phone", "7890", sqlite3pp::copy) << endl;
+      cout << cmd.execute_all() << endl;
+    }
+
+    {
+      // The INSERT can only be prepared once the table exists.
+      sqlite3pp::command cmd(db,
+			     "CREATE TEMP TABLE names (name TEXT);"
+			     "INSERT INTO names (name) VALUES ('user');"
+			     );
+      cout << cmd.execute_all() << endl;
+    }
+
+    {
+      // The last INSERT is prepared late, and gets :name although its
+      // statement has another parameter count than the first.
+      sqlite3pp::command cmd(db,
+			     "INSERT INTO contacts (name, phone) VALUES (:name, :phone);"
+			     "CREATE TEMP TABLE IF NOT EXISTS users (name TEXT);"
+			     "INSERT INTO users (name) VALUES (:name);"
+			     );
+      cout << cmd.bind(":name", "user4", sqlite3pp::copy) << endl;
+      cout << cmd.bind(":phone", "2345", sqlite3pp::copy) << endl;
+      cout << cmd.execute_all() << endl;
+
+      // It keeps the bindings for the next run.
+      cout << cmd.reset() << endl;
+      cout << cmd.execute_all() << endl;
+
+      sqlite3pp::query qry(db, "SELECT group_concat(name) FROM users");
+      cout << (*qry.begin()).get<std::string>(0) << endl;
+    }
+
+    {
+      // Nothing before the second statement changes the schema, so it
+      // can't ever be prepared, and binding already fails.
+      sqlite3pp::command cmd(db,
+			     "SELECT count(*) FROM contacts WHERE name = :name;"
+			     "INSERT INTO nowhere (name) VALUES (:name);"
+			     );
+      cout << cmd.bind(":name", "user5", sqlite3pp::copy) << endl;
+      cout << cmd.execute_all() << endl;
+    }
   }
   catch (exception& ex) {
     cout << ex.what() << endl;
@@ -0,0 +1,42 @@
+#include <cstdio>
+#include <iostream>
+#include "sqlite3pp.h"
+
+using namespace std;
+
+void print(sqlite3pp::database::options const& o)
+{
+  cout << "mmap_size: " << o.mmap_size << ", cache_size: " << o.cache_size << ", page_size: " << o.page_size
+       << ", journal_mode: " << o.journal_mode << ", synchronous: " << o.synchronous
+       << ", temp_store: " << o.temp_store << ", wal_autocheckpoint: " << o.wal_autocheckpoint << endl;
+}
+
+int main()
+{
+  try {
+    std::remove("options.db");
+
+    sqlite3pp::database::options opts;
+    opts.mmap_size = 256 * 1024 * 1024;
+    opts.cache_size = -16000;
+    opts.page_size = 8192;
+    opts.journal_mode = "wal";
+    opts.synchronous = 1;
+    opts.temp_store = 2;
+    opts.wal_autocheckpoint = 4000;
+    opts.lookaside_size = 256;
+    opts.lookaside_count = 200;
+
+    sqlite3pp::database db("options.db", opts);
+    print(db.tune());
+
+    sqlite3pp::database::options more;
+    more.synchronous = 2;
+    cout << db.tune(more) << endl;
+    print(db.tune());
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
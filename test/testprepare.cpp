@@ -0,0 +1,41 @@
+#include <cstring>
+#include <iostream>
+#include "sqlite3pp.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+
+    {
+      sqlite3pp::transaction xct(db);
+
+      sqlite3pp::command cmd(db, "INSERT INTO contacts (name, phone) VALUES (?, ?)", SQLITE_PREPARE_PERSISTENT);
+      for (int i = 0; i < 3; ++i) {
+        cmd.binder() << "AAAA" << "1234";
+        cout << cmd.execute() << endl;
+        cmd.reset();
+      }
+
+      // Only the first statement is prepared, which makes the query length
+      // stop before the trailing garbage.
+      char const sql[] = "SELECT count(*) FROM contacts WHERE name = 'AAAA' garbage";
+      sqlite3pp::query qry(db, sql, 0, static_cast<int>(std::strlen(sql) - std::strlen(" garbage")));
+      cout << (*qry.begin()).get<int>(0) << endl;
+
+      char const sqls[] = "INSERT INTO contacts (name, phone) VALUES (:name, '5678');"
+                          "INSERT INTO contacts (name, phone) VALUES (:name, '9012');"
+                          "this is not sql";
+      sqlite3pp::command cmds(db);
+      cout << cmds.prepare(sqls, SQLITE_PREPARE_PERSISTENT, static_cast<int>(std::strlen(sqls) - std::strlen("this is not sql"))) << endl;
+      cout << cmds.bind(":name", "BBBB", sqlite3pp::copy) << endl;
+      cout << cmds.execute_all() << endl;
+    }
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
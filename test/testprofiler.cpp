@@ -0,0 +1,56 @@
+#include <iostream>
+#include "sqlite3pp.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+
+    sqlite3pp::profiler prof(db);
+
+    {
+      sqlite3pp::transaction xct(db);
+
+      sqlite3pp::command cmd(db, "INSERT INTO contacts (name, phone) VALUES (?, ?)");
+      for (int i = 0; i < 5; ++i) {
+        cmd.binder() << "AAAA" << "1234";
+        cmd.execute();
+        cmd.reset();
+      }
+
+      xct.commit();
+    }
+
+    {
+      // There is no index on phone, so this scans the whole table.
+      sqlite3pp::query qry(db, "SELECT name FROM contacts WHERE phone = '1234' ORDER BY name");
+      for (auto it = qry.begin(); it != qry.end(); ++it) {
+      }
+      cout << "fullscan steps: " << qry.stmt_status(SQLITE_STMTSTATUS_FULLSCAN_STEP) << endl;
+    }
+
+    prof.disable();
+    db.execute("SELECT count(*) FROM contacts");
+
+    for (auto const& e : prof.snapshot()) {
+      cout << e.sql << endl;
+      cout << "  runs: " << e.runs << ", max_ns: " << e.max_ns
+           << ", fullscan: " << e.fullscan_steps << ", sorts: " << e.sorts << ", vm: " << e.vm_steps << endl;
+      cout << "  histogram:";
+      for (auto n : e.histogram) cout << " " << n;
+      cout << endl;
+    }
+
+    int progress = 0;
+    db.set_progress_handler(1, [&] { ++progress; return 0; });
+    db.execute("SELECT count(*) FROM contacts");
+    db.set_progress_handler(0, {});
+    cout << "progress calls: " << (progress > 0) << endl;
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
@@ -0,0 +1,75 @@
+#include <iostream>
+#include "sqlite3pp.h"
+
+using namespace std;
+
+int count(sqlite3pp::database& db)
+{
+  sqlite3pp::query qry(db, "SELECT count(*) FROM contacts");
+  return (*qry.begin()).get<int>(0);
+}
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+    cout << "before: " << count(db) << endl;
+
+    {
+      sqlite3pp::transaction xct(db, sqlite3pp::transaction_mode::exclusive);
+
+      db.execute("INSERT INTO contacts (name, phone) VALUES ('AAAA', '1234')");
+
+      {
+        sqlite3pp::savepoint sp(db);
+        db.execute("INSERT INTO contacts (name, phone) VALUES ('BBBB', '1234')");
+
+        {
+          sqlite3pp::savepoint sp2(db, true);
+          db.execute("INSERT INTO contacts (name, phone) VALUES ('CCCC', '1234')");
+        }
+        cout << "inner: " << count(db) << endl;
+      } // Rolled back, with the nested savepoint.
+
+      {
+        sqlite3pp::savepoint sp(db);
+        db.execute("INSERT INTO contacts (name, phone) VALUES ('DDDD', '1234')");
+        cout << sp.release() << endl;
+      }
+
+      cout << xct.commit() << endl;
+    }
+    cout << "after: " << count(db) << endl;
+
+    for (int i = 0; i < 1000; ++i) {
+      sqlite3pp::transaction xct(db, sqlite3pp::transaction_mode::deferred, true);
+      sqlite3pp::savepoint sp(db, true);
+    }
+    cout << "after loop: " << count(db) << endl;
+
+    {
+      // Releasing the outermost savepoint commits, which a reader holds up.
+      sqlite3pp::savepoint sp(db);
+      db.execute("INSERT INTO contacts (name, phone) VALUES ('EEEE', '1234')");
+
+      sqlite3pp::database db2("test.db");
+      sqlite3pp::query qry(db2, "SELECT name FROM contacts");
+      qry.begin();
+      cout << sp.release() << endl;
+
+      // The failed savepoint is still open, so this one gets another name.
+      {
+        sqlite3pp::savepoint sp2(db, true);
+        db.execute("INSERT INTO contacts (name, phone) VALUES ('FFFF', '1234')");
+      }
+
+      qry.reset();
+      cout << sp.release() << endl;
+    }
+    cout << "after busy: " << count(db) << endl;
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
@@ -45,6 +45,13 @@ int main()
 	(*i).getter() >> sqlite3pp::ignore >> name >> phone;
 	cout << id << "\t" << name << "\t" << phone << endl;
       }
+      cout << endl;
+
+      qry.reset();
+
+      for (auto v : qry) {
+	cout << v.get<int>("id") << "\t" << v.get<std::string>("name") << "\t" << v.get<char const*>("phone") << endl;
+      }
     }
   }
   catch (exception& ex) {
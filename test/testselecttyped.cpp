@@ -0,0 +1,35 @@
+#include <string>
+#include <iostream>
+#include "sqlite3pp.h"
+
+using namespace std;
+
+struct contact
+{
+  int id;
+  string name;
+  string phone;
+};
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+
+    sqlite3pp::query qry(db, "SELECT id, name, phone FROM contacts");
+
+    for (auto const& row : qry.as<int, string, string>()) {
+      cout << std::get<0>(row) << "\t" << std::get<1>(row) << "\t" << std::get<2>(row) << endl;
+    }
+    cout << endl;
+
+    qry.reset();
+
+    for (auto const& c : qry.as_struct(&contact::id, &contact::name, &contact::phone)) {
+      cout << c.id << "\t" << c.name << "\t" << c.phone << endl;
+    }
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+}
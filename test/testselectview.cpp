@@ -0,0 +1,50 @@
+#include <string>
+#include <iostream>
+#include "sqlite3pp.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    sqlite3pp::database db(":memory:");
+
+    db.execute("CREATE TABLE blobs (id INTEGER PRIMARY KEY, name TEXT, data BLOB)");
+    db.execute("INSERT INTO blobs (name, data) VALUES ('a' || char(0) || 'b', x'00010203')");
+    db.execute("INSERT INTO blobs (name, data) VALUES (NULL, NULL)");
+
+    sqlite3pp::query qry(db, "SELECT id, name, data FROM blobs");
+
+    for (auto v : qry) {
+      string name = v.get<string>(1);
+      sqlite3pp::blob_view data = v.get<sqlite3pp::blob_view>(2);
+      cout << v.get<int>(0) << "\t" << name.size() << "\t" << data.size << endl;
+    }
+    cout << endl;
+
+#ifdef SQLITE3PP_HAS_STRING_VIEW
+    qry.reset();
+
+    for (auto v : qry) {
+      int id;
+      std::string_view name;
+      sqlite3pp::blob_view data;
+      std::tie(id, name, data) = v.get_columns<int, std::string_view, sqlite3pp::blob_view>(0, 1, 2);
+      cout << id << "\t" << name.size() << "\t" << data.size << endl;
+    }
+    cout << endl;
+
+    qry.reset();
+
+    for (auto v : qry) {
+      std::string_view name;
+      sqlite3pp::blob_view data;
+      v.getter() >> sqlite3pp::ignore >> name >> data;
+      cout << name.size() << "\t" << data.size << endl;
+    }
+#endif
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+}
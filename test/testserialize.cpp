@@ -0,0 +1,57 @@
+#include <iostream>
+#include "sqlite3pp.h"
+
+using namespace std;
+
+int main()
+{
+#ifdef SQLITE3PP_HAS_SERIALIZE
+  try {
+    sqlite3pp::database db("test.db");
+
+    sqlite3pp::image img;
+    cout << db.serialize(img) << endl;
+    cout << "size: " << img.size() << ", owned: " << img.owned() << endl;
+
+    {
+      sqlite3pp::database mem(":memory:");
+      cout << mem.deserialize(std::move(img)) << endl;
+      cout << mem.execute("INSERT INTO contacts (name, phone) VALUES ('AAAA', '1234')") << endl;
+
+      sqlite3pp::query qry(mem, "SELECT count(*) FROM contacts");
+      cout << "count: " << (*qry.begin()).get<int>(0) << endl;
+
+      // An in-memory database can hand out its memory without a copy.
+      sqlite3pp::image view;
+      cout << mem.serialize(view, "main", true) << endl;
+      cout << "owned: " << view.owned() << endl;
+    }
+
+    {
+      sqlite3pp::image file;
+      cout << file.load("test.db") << endl;
+
+      sqlite3pp::database mem(":memory:");
+      cout << mem.deserialize(std::move(file), "main", true) << endl;
+      cout << mem.execute("INSERT INTO contacts (name, phone) VALUES ('AAAA', '1234')") << endl;
+    }
+
+#ifdef SQLITE3PP_HAS_MMAP
+    {
+      sqlite3pp::mapped_file mf("test.db");
+
+      sqlite3pp::database mem(":memory:");
+      cout << mem.deserialize(mf.data(), mf.size()) << endl;
+
+      sqlite3pp::query qry(mem, "SELECT name FROM contacts");
+      for (auto v : qry) {
+        cout << v.get<char const*>(0) << endl;
+      }
+    }
+#endif
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+#endif
+}
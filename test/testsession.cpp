@@ -0,0 +1,55 @@
+#include <iostream>
+#include "sqlite3ppext.h"
+
+using namespace std;
+
+int main()
+{
+#ifdef SQLITE_ENABLE_SESSION
+  try {
+    // A fresh source, so that row 100 is only in the replica.
+    sqlite3pp::database db(":memory:");
+    sqlite3pp::database replica(":memory:");
+    for (auto d : {&db, &replica}) {
+      d->execute("CREATE TABLE contacts (id INTEGER PRIMARY KEY, name TEXT NOT NULL, phone TEXT NOT NULL)");
+    }
+    replica.execute("INSERT INTO contacts (id, name, phone) VALUES (100, 'ZZZZ', '0000')");
+
+    sqlite3pp::ext::changeset cs;
+    {
+      sqlite3pp::ext::session s(db);
+      cout << s.attach("contacts") << endl;
+
+      cout << db.execute("INSERT INTO contacts (name, phone) VALUES ('AAAA', '1234')") << endl;
+      cout << db.execute("INSERT INTO contacts (id, name, phone) VALUES (100, 'BBBB', '5678')") << endl;
+
+      cout << "empty: " << s.empty() << endl;
+      cout << s.changeset(cs) << endl;
+    }
+
+    for (auto const& c : cs) {
+      cout << c.table() << " " << c.op() << " " << c.get_new<std::string>(1) << endl;
+    }
+
+    // Row 100 is already in the replica, so the handler decides.
+    auto rc = cs.apply(replica, [](int type, sqlite3pp::ext::changeset::change const& c) {
+      cout << "conflict " << type << " with " << sqlite3_value_text(c.conflict_value(1)) << endl;
+      return SQLITE_CHANGESET_REPLACE;
+    });
+    cout << rc << endl;
+
+    sqlite3pp::query qry(replica, "SELECT id, name FROM contacts");
+    for (auto v : qry) {
+      cout << v.get<int>(0) << " " << v.get<char const*>(1) << endl;
+    }
+
+    // Undoes the changes on the source.
+    sqlite3pp::ext::changeset undo;
+    cout << cs.invert(undo) << endl;
+    cout << undo.apply(db) << endl;
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+#endif
+}
@@ -0,0 +1,65 @@
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "sqlite3pp.h"
+#include "sqlite3ppthread.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    vector<string> files;
+    for (int s = 0; s < 4; ++s) {
+      files.push_back("shard" + to_string(s) + ".db");
+      remove(files.back().c_str());
+
+      sqlite3pp::database db(files.back().c_str());
+      db.execute("CREATE TABLE contacts (id INTEGER PRIMARY KEY, name TEXT NOT NULL, phone TEXT NOT NULL)");
+      sqlite3pp::transaction xct(db);
+      for (int i = s; i < 1000; i += 4) {
+        db.execute("INSERT INTO contacts (id, name, phone) VALUES (?, ?, ?)", i, "name" + to_string(i), to_string(i % 7));
+      }
+      xct.commit();
+    }
+
+    sqlite3pp::shard_set shards(files, 2);
+    cout << "shards: " << shards.size() << endl;
+
+    auto rows = shards.select<int, string>("SELECT id, name FROM contacts WHERE phone = ?", "3");
+    cout << "select: " << rows.size() << endl;
+
+    typedef tuple<int, string> row;
+    auto sorted = shards.select_sorted<int, string>([](row const& a, row const& b) { return get<0>(a) < get<0>(b); },
+                                                    "SELECT id, name FROM contacts WHERE id < ? ORDER BY id", 10);
+    for (auto const& r : sorted) {
+      cout << get<0>(r) << "\t" << get<1>(r) << endl;
+    }
+
+    // AVG() doesn't combine, so the shards return sum and count.
+    auto total = shards.reduce<long long, long long>([](tuple<long long, long long> a, tuple<long long, long long> const& b) {
+      get<0>(a) += get<0>(b);
+      get<1>(a) += get<1>(b);
+      return a;
+    }, "SELECT sum(id), count(*) FROM contacts");
+    cout << "avg: " << double(get<0>(total)) / get<1>(total) << endl;
+
+    size_t streamed = 0, batches = 0;
+    shards.stream<int>([&](size_t, vector<tuple<int>>& batch) {
+      streamed += batch.size();
+      ++batches;
+    }, "SELECT id FROM contacts");
+    cout << "stream: " << streamed << " rows in " << batches << " batches" << endl;
+
+    shards.for_each([](sqlite3pp::database& db, size_t i) {
+      if (i == 2 && db.execute("SELECT * FROM no_such_table") != SQLITE_OK)
+        throw sqlite3pp::database_error(db);
+    });
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
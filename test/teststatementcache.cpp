@@ -0,0 +1,74 @@
+#include <iostream>
+#include "sqlite3pp.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+
+    db.stmt_cache().set_capacity(2);
+
+    {
+      sqlite3pp::transaction xct(db);
+
+      for (int i = 0; i < 10; ++i) {
+        sqlite3pp::command cmd(db, "INSERT INTO contacts (name, phone) VALUES (?, ?)");
+        cmd.binder() << "AAAA" << "1234";
+        cout << cmd.execute() << endl;
+      }
+
+      {
+        // The same SQL text borrowed twice at once gets two statements.
+        sqlite3pp::query qry1(db, "SELECT count(*) FROM contacts");
+        sqlite3pp::query qry2(db, "SELECT count(*) FROM contacts");
+        cout << (*qry1.begin()).get<int>(0) << "\t" << (*qry2.begin()).get<int>(0) << endl;
+      }
+
+      sqlite3pp::query qry(db, "SELECT name FROM contacts WHERE phone = '1234'");
+      for (auto v : qry) {
+        cout << v.get<char const*>(0) << endl;
+      }
+    }
+
+    {
+      // Statements prepared with other flags aren't shared.
+      { sqlite3pp::query qry(db, "SELECT 1"); }
+      { sqlite3pp::query qry(db, "SELECT 1", SQLITE_PREPARE_NO_VTAB); }
+      { sqlite3pp::query qry(db, "SELECT 1", SQLITE_PREPARE_NO_VTAB); }
+      cout << "size: " << db.stmt_cache().size() << endl;
+    }
+
+    {
+      // A statement borrowed during clear() goes when it comes back.
+      sqlite3pp::query qry(db, "SELECT 2");
+      db.stmt_cache().clear();
+      cout << "size: " << db.stmt_cache().size() << endl;
+    }
+    cout << "size: " << db.stmt_cache().size() << endl;
+
+    {
+      // So does one borrowed while its database is assigned over.
+      sqlite3pp::database db1(":memory:");
+      db1.stmt_cache().set_capacity(2);
+      sqlite3pp::query qry(db1, "SELECT 1");
+      qry.begin();
+      db1 = sqlite3pp::database(":memory:");
+      cout << "size: " << db1.stmt_cache().size() << endl;
+      qry.finish();
+      cout << "size: " << db1.stmt_cache().size() << endl;
+    }
+
+    auto& sc = db.stmt_cache();
+    cout << "size: " << sc.size() << ", hits: " << sc.hits() << ", misses: " << sc.misses()
+         << ", evictions: " << sc.evictions() << endl;
+
+    sc.clear();
+    cout << "size: " << sc.size() << endl;
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
@@ -0,0 +1,80 @@
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include "sqlite3ppext.h"
+
+using namespace std;
+
+// Counts the reads of every file it opens.
+class counting_vfs : public sqlite3pp::ext::vfs
+{
+ public:
+  counting_vfs() : vfs("counting"), reads(0) {}
+
+  std::atomic<int> reads;
+
+ protected:
+  class counting_file : public file
+  {
+   public:
+    counting_file(sqlite3_file* base, std::atomic<int>& reads) : file(base), reads_(reads) {}
+
+    int read(void* data, int n, sqlite3_int64 off) override {
+      ++reads_;
+      return file::read(data, n, off);
+    }
+
+   private:
+    std::atomic<int>& reads_;
+  };
+
+  std::unique_ptr<file> open(char const*, int, sqlite3_file* base) override {
+    return std::unique_ptr<file>(new counting_file(base, reads));
+  }
+};
+
+int main()
+{
+  try {
+    counting_vfs cv;
+    sqlite3pp::ext::readahead_vfs rv("readahead", 64 * 1024);
+
+    {
+      sqlite3pp::database db("test.db", SQLITE_OPEN_READWRITE, "counting");
+      sqlite3pp::query qry(db, "SELECT count(*) FROM contacts");
+      cout << (*qry.begin()).get<int>(0) << ", reads: " << (cv.reads > 0) << endl;
+    }
+
+    {
+      sqlite3pp::database db("vfs.db", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, "readahead");
+      db.execute("PRAGMA journal_mode=WAL");
+      db.execute("DROP TABLE IF EXISTS t");
+      db.execute("CREATE TABLE t (id INTEGER PRIMARY KEY, v TEXT)");
+      {
+        sqlite3pp::transaction xct(db);
+        sqlite3pp::command cmd(db, "INSERT INTO t (v) VALUES (?)");
+        for (int i = 0; i < 20000; ++i) {
+          cmd.binder() << "a fairly long text value to fill some pages";
+          cmd.execute();
+          cmd.reset();
+        }
+        xct.commit();
+      }
+      db.execute("PRAGMA wal_checkpoint(TRUNCATE)");
+
+      sqlite3pp::database other("vfs.db", SQLITE_OPEN_READWRITE, "readahead");
+      cout << other.query_one<int>("SELECT count(*) FROM t WHERE v LIKE 'a%'") << endl;
+
+      // A write through one connection shows up in the next scan of the other.
+      db.execute("UPDATE t SET v = 'b' WHERE id % 2 = 0");
+      db.execute("PRAGMA wal_checkpoint(TRUNCATE)");
+      cout << other.query_one<int>("SELECT count(*) FROM t WHERE v LIKE 'a%'") << endl;
+
+      cout << "fills: " << (rv.fills() > 0) << ", hits: " << (rv.hits() > rv.fills()) << endl;
+    }
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
@@ -0,0 +1,178 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "sqlite3pp.h"
+#include "sqlite3ppext.h"
+
+using namespace std;
+
+struct contact
+{
+  int id;
+  string name;
+};
+
+// The rows of a vector, with a seek on id.
+struct contacts_table
+{
+  char const* schema() const {
+    return "CREATE TABLE x(id INTEGER, name TEXT)";
+  }
+
+  void best_index(sqlite3pp::ext::index_info& info) const {
+    for (int i = 0; i < info.constraint_count(); ++i) {
+      if (info.constraint_usable(i) && info.constraint_column(i) == 0 &&
+          info.constraint_op(i) == SQLITE_INDEX_CONSTRAINT_EQ) {
+        info.use(i);
+        info.set_index(1);
+        info.set_cost(1);
+        info.set_rows(1);
+        return;
+      }
+    }
+    info.set_cost(static_cast<double>(rows.size()));
+    info.set_rows(static_cast<long long int>(rows.size()));
+  }
+
+  struct cursor
+  {
+    explicit cursor(contacts_table& t) : t_(t), i_(0), end_(0) {}
+
+    void filter(int idxnum, sqlite3pp::ext::context& args) {
+      i_ = 0;
+      end_ = t_.rows.size();
+      if (idxnum == 1) {
+        auto id = args.get<int>(0);
+        for (i_ = 0; i_ < end_ && t_.rows[i_].id != id; ++i_) {}
+        end_ = i_ < end_ ? i_ + 1 : i_;
+      }
+    }
+    void next() {
+      ++i_;
+    }
+    bool eof() const {
+      return i_ >= end_;
+    }
+    void column(sqlite3pp::ext::context& c, int col) const {
+      if (col == 0)
+        c.result(t_.rows[i_].id);
+      else
+        c.result(t_.rows[i_].name);
+    }
+    long long int rowid() const {
+      return static_cast<long long int>(i_);
+    }
+
+    contacts_table& t_;
+    size_t i_;
+    size_t end_;
+  };
+
+  vector<contact> rows;
+};
+
+// A table-valued function: series(start, stop).
+struct series_table
+{
+  char const* schema() const {
+    return "CREATE TABLE x(value INTEGER, start HIDDEN, stop HIDDEN)";
+  }
+
+  void best_index(sqlite3pp::ext::index_info& info) const {
+    int start = -1, stop = -1;
+    bool funusable = false;
+    for (int i = 0; i < info.constraint_count(); ++i) {
+      if (info.constraint_op(i) != SQLITE_INDEX_CONSTRAINT_EQ)
+        continue;
+      if (!info.constraint_usable(i)) {
+        funusable = true;
+        continue;
+      }
+      if (info.constraint_column(i) == 1) start = i;
+      if (info.constraint_column(i) == 2) stop = i;
+    }
+    if (start < 0 || stop < 0) {
+      if (!funusable)
+        throw runtime_error("series() needs start and stop");
+      info.reject();
+      return;
+    }
+    info.use(start);
+    info.use(stop);
+  }
+
+  struct cursor
+  {
+    explicit cursor(series_table&) : v_(0), stop_(0), start_(0) {}
+
+    void filter(int, sqlite3pp::ext::context& args) {
+      start_ = v_ = args.get<long long int>(0);
+      stop_ = args.get<long long int>(1);
+    }
+    void next() {
+      ++v_;
+    }
+    bool eof() const {
+      if (stop_ - start_ >= 1000)
+        throw runtime_error("series() is limited to 1000 values");
+      return v_ > stop_;
+    }
+    void column(sqlite3pp::ext::context& c, int col) const {
+      c.result(col == 0 ? v_ : col == 1 ? start_ : stop_);
+    }
+    long long int rowid() const {
+      return v_;
+    }
+
+    long long int v_, stop_, start_;
+  };
+};
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+
+    contacts_table contacts;
+    contacts.rows = {{1, "Mike"}, {2, "Jane"}, {3, "Bob"}};
+    series_table series;
+
+    sqlite3pp::ext::vtable<contacts_table> vt(db);
+    cout << vt.create("cache", contacts) << endl;
+    sqlite3pp::ext::vtable<series_table> st(db);
+    cout << st.create("series", series) << endl;
+
+    sqlite3pp::query qry(db, "SELECT id, name FROM cache WHERE id = 2");
+    for (auto v : qry) {
+      cout << v.get<int>(0) << "\t" << v.get<char const*>(1) << endl;
+    }
+
+    sqlite3pp::query jqry(db, "SELECT c.name, s.value FROM cache c JOIN series(1, 2) s ON s.value = c.id");
+    for (auto v : jqry) {
+      cout << v.get<char const*>(0) << "\t" << v.get<int>(1) << endl;
+    }
+
+    sqlite3pp::query cqry(db, "SELECT c.name, s.value FROM cache c, series(c.id, 3) s WHERE c.id >= 2");
+    for (auto v : cqry) {
+      cout << v.get<char const*>(0) << "\t" << v.get<int>(1) << endl;
+    }
+
+    // The modules are eponymous-only.
+    cout << db.execute("CREATE VIRTUAL TABLE temp.cache2 USING cache") << endl;
+
+    // Errors of the table reach the query.
+    sqlite3pp::query big(db, "SELECT count(*) FROM series(1, 5000)");
+    try {
+      big.begin();
+    }
+    catch (exception& ex) {
+      cout << ex.what() << endl;
+    }
+
+    sqlite3pp::query bad(db, "SELECT * FROM series");
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}
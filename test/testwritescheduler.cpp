@@ -0,0 +1,63 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "sqlite3pp.h"
+#include "sqlite3ppthread.h"
+
+using namespace std;
+
+int main()
+{
+  try {
+    sqlite3pp::database db("test.db");
+
+    {
+      sqlite3pp::write_scheduler ws(db, 100, std::chrono::milliseconds(2));
+
+      vector<thread> writers;
+      vector<int> failures(4, 0);
+      for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&ws, &failures, t] {
+          for (int i = 0; i < 250; ++i) {
+            auto f = ws.submit([](sqlite3pp::database& db) {
+              return db.execute("INSERT INTO contacts (name, phone) VALUES ('AAAA', '1234')");
+            });
+            if (f.get() != SQLITE_OK) ++failures[t];
+          }
+        });
+      }
+      for (auto& w : writers) w.join();
+      cout << "failures: " << failures[0] + failures[1] + failures[2] + failures[3] << endl;
+
+      // A failing job is rolled back alone.
+      auto f1 = ws.submit([](sqlite3pp::database& db) {
+        db.execute("INSERT INTO contacts (name, phone) VALUES ('BBBB', '1234')");
+        return db.execute("INSERT INTO contacts (name) VALUES ('BBBB')");
+      });
+      sqlite3pp::command cmd(db, "INSERT INTO contacts (name, phone) VALUES ('CCCC', '1234')");
+      auto f2 = ws.submit(cmd);
+      auto f3 = ws.submit([](sqlite3pp::database&) -> int {
+        throw runtime_error("job failed");
+      });
+      cout << f1.get() << "\t" << f2.get() << endl;
+      try {
+        f3.get();
+      }
+      catch (exception& ex) {
+        cout << ex.what() << endl;
+      }
+
+      ws.stop();
+      cout << "jobs: " << ws.jobs() << ", fewer batches: " << (ws.batches() < ws.jobs()) << endl;
+    }
+
+    sqlite3pp::query qry(db, "SELECT name, count(*) FROM contacts GROUP BY name");
+    for (auto v : qry) {
+      cout << v.get<char const*>(0) << "\t" << v.get<int>(1) << endl;
+    }
+  }
+  catch (exception& ex) {
+    cout << ex.what() << endl;
+  }
+
+}